@@ -0,0 +1,4699 @@
+/*
+Loguru logging library for C++, by Emil Ernerfeldt.
+www.github.com/emilk/loguru
+If you find Loguru useful, please let me know on twitter or in a mail!
+Twitter: @ernerfeldt
+Mail:    emil.ernerfeldt@gmail.com
+Website: www.ilikebigbits.com
+
+# License
+	This software is in the public domain. Where that dedication is not
+	recognized, you are granted a perpetual, irrevocable license to copy
+	and modify this file as you see fit.
+
+# About
+	The implementation of loguru.hpp. Compile this file once, either by adding it
+	to your build or by linking with the loguru CMake target.
+	It is also #included by loguru.hpp when LOGURU_IMPLEMENTATION is defined.
+*/
+
+#ifndef LOGURU_IMPLEMENTATION
+	#define LOGURU_IMPLEMENTATION 1
+#endif
+#define LOGURU_HAS_BEEN_IMPLEMENTED
+
+#include "loguru.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdarg>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <ctime>
+#include <memory>
+#include <mutex>
+#include <new>
+#include <regex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+#ifdef _MSC_VER
+	#include <direct.h>
+	#include <sys/stat.h> // stat
+
+	#define localtime_r(a, b) localtime_s(b, a) // No localtime_r with MSVC, but arguments are swapped for localtime_s
+#else
+	#include <signal.h>
+	#include <fcntl.h>
+	#include <sys/mman.h>  // mmap
+	#include <sys/socket.h>
+	#include <sys/stat.h> // mkdir
+	#include <sys/un.h>   // sockaddr_un
+	#include <unistd.h>   // STDERR_FILENO
+#endif
+
+#ifdef __linux__
+	#include <sched.h>        // sched_getcpu
+	#include <linux/limits.h> // PATH_MAX
+#elif !defined(_WIN32)
+	#include <limits.h> // PATH_MAX
+#endif
+
+#ifndef PATH_MAX
+	#define PATH_MAX 1024
+#endif
+
+#ifdef __APPLE__
+	#include "TargetConditionals.h"
+#endif
+
+// TODO: use defined(_POSIX_VERSION) for some of these things?
+
+#if defined(_WIN32) || defined(__CYGWIN__)
+	#define LOGURU_PTHREADS    0
+	#define LOGURU_WINTHREADS  1
+	#define LOGURU_STACKTRACES 0
+#else
+	#define LOGURU_PTHREADS    1
+	#define LOGURU_WINTHREADS  0
+	#define LOGURU_STACKTRACES 1
+#endif
+
+#if (defined(__x86_64__) || defined(__i386__)) && (defined(__GNUC__) || defined(__clang__))
+	#include <cpuid.h>     // for __get_cpuid
+	#include <x86intrin.h> // for __rdtsc
+#endif
+
+#if LOGURU_STACKTRACES
+	#include <cxxabi.h>    // for __cxa_demangle
+	#include <dlfcn.h>     // for dladdr
+	#include <execinfo.h>  // for backtrace
+#endif // LOGURU_STACKTRACES
+
+#if LOGURU_PTHREADS
+	#include <pthread.h>
+
+	#ifdef __linux__
+		/* On Linux, the default thread name is the same as the name of the binary.
+		   Additionally, all new threads inherit the name of the thread it got forked from.
+		   For this reason, Loguru use the pthread Thread Local Storage
+		   for storing thread names on Linux. */
+		#define LOGURU_PTLS_NAMES 1
+	#endif
+#endif
+
+#if LOGURU_WINTHREADS
+	#ifndef _WIN32_WINNT
+		#define _WIN32_WINNT 0x0502
+	#endif
+	#define WIN32_LEAN_AND_MEAN
+	#define NOMINMAX
+	#include <windows.h>
+#endif
+
+#ifndef LOGURU_PTLS_NAMES
+   #define LOGURU_PTLS_NAMES 0
+#endif
+
+namespace loguru
+{
+	using namespace std::chrono;
+
+#if LOGURU_WITH_FILEABS
+	struct FileAbs
+	{
+		char path[PATH_MAX];
+		char mode_str[4];
+		Verbosity verbosity;
+		struct stat st;
+		FILE* fp;
+		bool is_reopening = false; // to prevent recursive call in file_reopen.
+		decltype(steady_clock::now()) last_check_time = steady_clock::now();
+	};
+#else
+	typedef FILE* FileAbs;
+#endif
+
+	// Used by the built-in text sinks: gets the fully rendered line (including the trailing newline).
+	typedef void (*line_handler_t)(void* user_data, const Message& message, const char* line, size_t length);
+
+	struct CompiledFilter
+	{
+		std::string file;      // Empty means any.
+		std::string thread;    // Empty means any.
+		bool        has_message;
+		std::regex  message;
+	};
+
+	// Copies of messages, kept for later. Clearing keeps the memory for reuse.
+	struct MessageStore
+	{
+		struct Entry
+		{
+			Message message;
+			size_t  offsets[5]; // Of preamble, indentation, prefix, message and context in storage.
+		};
+
+		std::string        storage; // The strings of all entries, zero-terminated.
+		std::vector<Entry> entries;
+
+		void add(const Message& message)
+		{
+			Entry entry;
+			entry.message = message;
+			const char* strings[5] = { message.preamble, message.indentation, message.prefix, message.message, message.context };
+			for (int i = 0; i < 5; ++i) {
+				entry.offsets[i] = storage.size();
+				storage.append(strings[i], strlen(strings[i]) + 1);
+			}
+			entries.push_back(entry);
+		}
+
+		Message get(size_t index) const
+		{
+			const auto& entry = entries[index];
+			Message message = entry.message;
+			message.preamble    = storage.data() + entry.offsets[0];
+			message.indentation = storage.data() + entry.offsets[1];
+			message.prefix      = storage.data() + entry.offsets[2];
+			message.message     = storage.data() + entry.offsets[3];
+			message.context     = storage.data() + entry.offsets[4];
+			return message;
+		}
+
+		void clear()
+		{
+			storage.clear();
+			entries.clear();
+		}
+	};
+
+	// Messages waiting for a batch callback.
+	struct Batch
+	{
+		unsigned                 max_size;
+		unsigned                 max_latency_ms;
+		MessageStore             pending;
+		steady_clock::time_point first_time; // When the oldest entry was added.
+	};
+
+	struct Callback
+	{
+		std::string     id;
+		log_handler_t   callback;
+		void*           user_data;
+		Verbosity       verbosity; // Only changed with s_mutex held (see on_callback_change).
+		close_handler_t close;
+		flush_handler_t flush;
+		line_handler_t  line_callback; // If set, used instead of 'callback'.
+		std::vector<CompiledFilter> filters;
+		batch_handler_t batch_callback; // If set, used instead of 'callback', with messages collected in 'batch'.
+		std::shared_ptr<Batch> batch;
+		Verbosity       raised_verbosity; // Accepts messages of raised threads up to this (see ScopedVerbosity).
+	};
+
+	// Which filtered sinks a call site may reach. Bit i is for s_callbacks[i].
+	struct CallsiteRouting
+	{
+		uint64_t  accept; // File matched a rule with nothing else to check.
+		uint64_t  check;  // File matched a rule with thread or message parts: check those per message.
+		bool      has_module_verbosity;
+		Verbosity module_verbosity; // Replaces g_stderr_verbosity for this call site.
+	};
+
+	struct ModuleVerbosity
+	{
+		std::string file_glob;
+		Verbosity   verbosity;
+	};
+
+	struct CallsiteKey
+	{
+		const char* file;
+		unsigned    line;
+		bool operator==(const CallsiteKey& other) const { return file == other.file && line == other.line; }
+	};
+
+	struct CallsiteKeyHash
+	{
+		size_t operator()(const CallsiteKey& key) const
+		{
+			return std::hash<const void*>()(key.file) ^ (static_cast<size_t>(key.line) * 0x9E3779B97F4A7C15ull);
+		}
+	};
+
+	// Sinks past this index are not cached, but evaluated in full for every message.
+	const size_t MAX_CACHED_CALLBACKS = 64;
+
+	using CallbackVec = std::vector<Callback>;
+
+	using StringPair     = std::pair<std::string, std::string>;
+	using StringPairList = std::vector<StringPair>;
+
+	const auto SCOPE_TIME_PRECISION = 3; // 3=ms, 6≈us, 9=ns
+
+	const auto s_start_time = steady_clock::now();
+
+	Verbosity g_stderr_verbosity  = Verbosity_0;
+	bool      g_colorlogtostderr  = true;
+	unsigned  g_flush_interval_ms = 0;
+
+	// g_stderr_verbosity is a plain public variable, but the config watcher changes it from another thread.
+	Verbosity stderr_verbosity()
+	{
+	#if defined(__GNUC__) || defined(__clang__)
+		return __atomic_load_n(&g_stderr_verbosity, __ATOMIC_RELAXED);
+	#else
+		return *static_cast<volatile Verbosity*>(&g_stderr_verbosity); // Aligned ints do not tear.
+	#endif
+	}
+
+	void set_stderr_verbosity(Verbosity verbosity)
+	{
+	#if defined(__GNUC__) || defined(__clang__)
+		__atomic_store_n(&g_stderr_verbosity, verbosity, __ATOMIC_RELAXED);
+	#else
+		*static_cast<volatile Verbosity*>(&g_stderr_verbosity) = verbosity;
+	#endif
+	}
+
+	unsigned g_verbosity_generation = 1;
+	LOGURU_THREAD_LOCAL VerbosityCutoffCache g_verbosity_cutoff_cache; // Zeroed, so computed on first use.
+
+	// Call after changing anything current_verbosity_cutoff depends on, other than g_stderr_verbosity.
+	static void bump_verbosity_generation()
+	{
+	#if defined(__GNUC__) || defined(__clang__)
+		if (__atomic_add_fetch(&g_verbosity_generation, 1, __ATOMIC_RELEASE) == 0) {
+			__atomic_add_fetch(&g_verbosity_generation, 1, __ATOMIC_RELEASE); // 0 means "not computed".
+		}
+	#else
+		// Only called with s_mutex held, so there are no concurrent bumps.
+		volatile unsigned& generation = *static_cast<volatile unsigned*>(&g_verbosity_generation);
+		generation = generation + 1 == 0 ? 1 : generation + 1;
+	#endif
+	}
+
+	/*  A recursive mutex that counts its own depth on top of a plain mutex, so that after fork()
+		the one thread left in the child can still unlock what it locked in the parent
+		(a recursive pthread mutex remembers the thread id of its owner, which changes in the child). */
+	class LogMutex
+	{
+	public:
+		void lock()
+		{
+			if (_owner.load(std::memory_order_relaxed) == std::this_thread::get_id()) {
+				_depth += 1;
+				return;
+			}
+			_mutex.lock();
+			_owner.store(std::this_thread::get_id(), std::memory_order_relaxed);
+			_depth = 1;
+		}
+
+		bool try_lock()
+		{
+			if (_owner.load(std::memory_order_relaxed) == std::this_thread::get_id()) {
+				_depth += 1;
+				return true;
+			}
+			if (!_mutex.try_lock()) { return false; }
+			_owner.store(std::this_thread::get_id(), std::memory_order_relaxed);
+			_depth = 1;
+			return true;
+		}
+
+		void unlock()
+		{
+			if (--_depth == 0) {
+				_owner.store(std::thread::id(), std::memory_order_relaxed);
+				_mutex.unlock();
+			}
+		}
+
+	private:
+		std::mutex                   _mutex;
+		std::atomic<std::thread::id> _owner { std::thread::id() };
+		unsigned                     _depth = 0; // Only touched by the owner.
+	};
+
+	static LogMutex              s_mutex;
+	static std::atomic<Verbosity> s_max_out_verbosity { Verbosity_OFF }; // Read without s_mutex.
+	static std::atomic<Verbosity> s_max_raised_verbosity { Verbosity_OFF }; // Of all outputs. Read without s_mutex.
+	static std::string           s_argv0_filename;
+	static std::string           s_arguments;
+	static char                  s_current_dir[PATH_MAX];
+	static CallbackVec           s_callbacks;
+	static fatal_handler_t       s_fatal_handler   = nullptr;
+	static StringPairList        s_user_stack_cleanups;
+#if !LOGURU_USE_FILE_NAME
+	static bool                  s_strip_file_path = true;
+#endif
+	static std::atomic<unsigned> s_stderr_indentation { 0 };
+	static bool                  s_has_filters = false;
+	static std::atomic<bool>     s_has_thread_filters { false }; // Read by async producers without s_mutex.
+	static std::vector<ModuleVerbosity> s_module_verbosities;
+
+	// For watch_verbosity_config:
+	static std::thread*          s_config_thread = nullptr;
+	static std::string           s_config_path;
+	static unsigned              s_config_poll_interval_ms = 0;
+	static bool                  s_config_restart_needed = false; // Set in a forked child.
+	static std::atomic<bool>     s_config_reload_requested { false };
+	static std::atomic<bool>     s_config_stop { false };
+#ifndef _WIN32
+	static bool                  s_config_sighup = false; // Installed on_reload_signal.
+	static struct sigaction      s_config_old_sighup; // Restored by unwatch_verbosity_config.
+#endif
+	static std::unordered_map<CallsiteKey, CallsiteRouting, CallsiteKeyHash> s_callsite_routing;
+
+	// localtime_r takes a lock inside libc. We hold this one across fork() (see on_fork_prepare),
+	// so a child never inherits that lock held by a logging thread that does not exist there.
+	static std::mutex            s_localtime_mutex;
+
+	// For periodic flushing:
+	static std::thread* s_flush_thread   = nullptr;
+	static bool         s_needs_flushing = false;
+	static unsigned     s_batch_tick_ms  = 0; // How often the flusher checks on batch callbacks. 0 if there are none.
+
+	// For start_async:
+	struct AsyncShard;
+	static std::atomic<bool>     s_async_enabled { false };
+	static std::atomic<bool>     s_async_needs_thread { false }; // Set in a forked child.
+	static std::atomic<bool>     s_async_wake_requested { false };
+	static AsyncShard*           s_async_shards = nullptr; // Allocated once, never freed.
+	static size_t                s_async_num_shards = 0;
+	static size_t                s_async_shard_size = 0;
+	static unsigned              s_async_latency_ms = 10;
+	static std::thread*          s_async_thread = nullptr;
+	// Never destroyed: the async thread may still be waiting on them during exit.
+	static std::mutex&           s_async_wake_mutex = *new std::mutex();
+	static std::condition_variable& s_async_wake   = *new std::condition_variable();
+	static bool                  s_async_draining = false; // Only touched with s_mutex held.
+	static const char*           s_drain_thread_name = nullptr; // Producer of the record being drained, for thread filters.
+	static bool                  s_async_stuck = false; // A shard lock timed out in an emergency drain.
+	static std::atomic<int>      s_async_priority_verbosity { Verbosity_FATAL };
+
+	static const bool s_terminal_has_color = [](){
+		#ifdef _WIN32
+			#ifndef ENABLE_VIRTUAL_TERMINAL_PROCESSING
+			#define ENABLE_VIRTUAL_TERMINAL_PROCESSING  0x0004
+			#endif
+
+			HANDLE hOut = GetStdHandle(STD_OUTPUT_HANDLE);
+			if (hOut != INVALID_HANDLE_VALUE) {
+				DWORD dwMode = 0;
+				GetConsoleMode(hOut, &dwMode);
+				dwMode |= ENABLE_VIRTUAL_TERMINAL_PROCESSING;
+				return SetConsoleMode(hOut, dwMode) != 0;
+			}
+			return false;
+		#else
+			if (const char* term = getenv("TERM")) {
+				return 0 == strcmp(term, "cygwin")
+					|| 0 == strcmp(term, "linux")
+					|| 0 == strcmp(term, "rxvt-unicode-256color")
+					|| 0 == strcmp(term, "screen")
+					|| 0 == strcmp(term, "screen-256color")
+					|| 0 == strcmp(term, "tmux-256color")
+					|| 0 == strcmp(term, "xterm")
+					|| 0 == strcmp(term, "xterm-256color")
+					|| 0 == strcmp(term, "xterm-termite")
+					|| 0 == strcmp(term, "xterm-color");
+			} else {
+				return false;
+			}
+		#endif
+	}();
+
+	// ------------------------------------------------------------------------------
+	// Preamble:
+
+	const char* const DEFAULT_PREAMBLE_PATTERN = "%D %T.%ms (%ups) [%t]%f:%l %v| ";
+
+	enum class PreambleField { Literal, Date, Time, Millis, EpochNs, Uptime, Thread, File, Line, Verbosity };
+
+	struct PreambleOp
+	{
+		PreambleField field;
+		std::string   literal; // Only for PreambleField::Literal.
+	};
+
+	// A preamble pattern compiled to a list of field writers.
+	struct PreambleProgram
+	{
+		std::vector<PreambleOp> ops;
+		bool                    needs_local_time = false;
+		bool                    needs_uptime    = false;
+		std::string             explain; // Column headers, e.g. "date       time  ..."
+	};
+
+	static bool compile_preamble(const char* pattern, PreambleProgram* out_program)
+	{
+		struct FieldInfo { const char* token; PreambleField field; int width; const char* label; bool left_align; };
+		static const FieldInfo FIELDS[] = {
+			{ "ms", PreambleField::Millis,    3,                       "",                true  },
+			{ "ns", PreambleField::EpochNs,   19,                      "epoch ns",        true  },
+			{ "up", PreambleField::Uptime,    8,                       " uptime",         true  },
+			{ "D",  PreambleField::Date,      10,                      "date",            true  },
+			{ "T",  PreambleField::Time,      8,                       "time",            true  },
+			{ "t",  PreambleField::Thread,    LOGURU_THREADNAME_WIDTH, " thread name/id", true  },
+			{ "f",  PreambleField::File,      LOGURU_FILENAME_WIDTH,   "file",            false },
+			{ "l",  PreambleField::Line,      5,                       "line",            true  },
+			{ "v",  PreambleField::Verbosity, 4,                       "v",               false },
+		};
+
+		PreambleProgram program;
+		for (const char* ptr = pattern; *ptr; ) {
+			if (ptr[0] == '%' && ptr[1] == '%') {
+				ptr += 2;
+				if (program.ops.empty() || program.ops.back().field != PreambleField::Literal) {
+					program.ops.push_back(PreambleOp{PreambleField::Literal, ""});
+				}
+				program.ops.back().literal += '%';
+				program.explain += '%';
+				continue;
+			}
+			if (ptr[0] == '%') {
+				const FieldInfo* found = nullptr;
+				for (const auto& info : FIELDS) {
+					if (strncmp(ptr + 1, info.token, strlen(info.token)) == 0) {
+						found = &info;
+						break;
+					}
+				}
+				if (!found) {
+					return false;
+				}
+				ptr += 1 + strlen(found->token);
+				program.ops.push_back(PreambleOp{found->field, ""});
+				program.needs_local_time |= (found->field == PreambleField::Date ||
+											 found->field == PreambleField::Time ||
+											 found->field == PreambleField::Millis);
+				program.needs_uptime |= (found->field == PreambleField::Uptime);
+				auto label = textprintf(found->left_align ? "%-*s" : "%*s", found->width, found->label);
+				program.explain += label.c_str();
+				continue;
+			}
+			if (program.ops.empty() || program.ops.back().field != PreambleField::Literal) {
+				program.ops.push_back(PreambleOp{PreambleField::Literal, ""});
+			}
+			program.ops.back().literal += *ptr;
+			// Keep the brackets etc, but blank out things like the '.' between time and ms.
+			program.explain += (isalnum(static_cast<unsigned char>(*ptr)) || *ptr == '.') ? ' ' : *ptr;
+			++ptr;
+		}
+		*out_program = std::move(program);
+		return true;
+	}
+
+	static const PreambleProgram* default_preamble_program()
+	{
+		static const PreambleProgram* s_default = [](){
+			auto program = new PreambleProgram();
+			compile_preamble(DEFAULT_PREAMBLE_PATTERN, program);
+			return program;
+		}();
+		return s_default;
+	}
+
+	// print_preamble runs without s_mutex, so replaced programs are leaked rather than freed.
+	static std::atomic<const PreambleProgram*> s_preamble_program { nullptr };
+
+	static const PreambleProgram& preamble_program()
+	{
+		const PreambleProgram* program = s_preamble_program.load(std::memory_order_acquire);
+		return program ? *program : *default_preamble_program();
+	}
+
+	static const char* preamble_explain()
+	{
+		return preamble_program().explain.c_str();
+	}
+
+	#if LOGURU_PTLS_NAMES
+		static pthread_once_t s_pthread_key_once = PTHREAD_ONCE_INIT;
+		static pthread_key_t  s_pthread_key_name;
+
+		void make_pthread_key_name()
+		{
+			(void)pthread_key_create(&s_pthread_key_name, free);
+		}
+	#endif
+
+	// ------------------------------------------------------------------------------
+	// Colors
+
+	bool terminal_has_color() { return s_terminal_has_color; }
+
+	// Colors
+
+#ifdef _WIN32
+#define VTSEQ(ID) ("\x1b[1;" #ID "m")
+#else
+#define VTSEQ(ID) ("\x1b[" #ID "m")
+#endif
+
+	const char* terminal_black()      { return s_terminal_has_color ? VTSEQ(30) : ""; }
+	const char* terminal_red()        { return s_terminal_has_color ? VTSEQ(31) : ""; }
+	const char* terminal_green()      { return s_terminal_has_color ? VTSEQ(32) : ""; }
+	const char* terminal_yellow()     { return s_terminal_has_color ? VTSEQ(33) : ""; }
+	const char* terminal_blue()       { return s_terminal_has_color ? VTSEQ(34) : ""; }
+	const char* terminal_purple()     { return s_terminal_has_color ? VTSEQ(35) : ""; }
+	const char* terminal_cyan()       { return s_terminal_has_color ? VTSEQ(36) : ""; }
+	const char* terminal_light_gray() { return s_terminal_has_color ? VTSEQ(37) : ""; }
+	const char* terminal_white()      { return s_terminal_has_color ? VTSEQ(37) : ""; }
+	const char* terminal_light_red()  { return s_terminal_has_color ? VTSEQ(91) : ""; }
+	const char* terminal_dim()        { return s_terminal_has_color ? VTSEQ(2)  : ""; }
+
+	// Formating
+	const char* terminal_bold()       { return s_terminal_has_color ? VTSEQ(1) : ""; }
+	const char* terminal_underline()  { return s_terminal_has_color ? VTSEQ(4) : ""; }
+
+	// You should end each line with this!
+	const char* terminal_reset()      { return s_terminal_has_color ? VTSEQ(0) : ""; }
+
+	// ------------------------------------------------------------------------------
+#if LOGURU_WITH_FILEABS
+	void file_reopen(void* user_data);
+	inline FILE* to_file(void* user_data) { return reinterpret_cast<FileAbs*>(user_data)->fp; }
+#else
+	inline FILE* to_file(void* user_data) { return reinterpret_cast<FILE*>(user_data); }
+#endif
+
+	void file_log(void* user_data, const Message&, const char* line, size_t length)
+	{
+#if LOGURU_WITH_FILEABS
+		FileAbs* file_abs = reinterpret_cast<FileAbs*>(user_data);
+		if (file_abs->is_reopening) {
+			return;
+		}
+		// It is better checking file change every minute/hour/day,
+		// instead of doing this every time we log.
+		// Here check_interval is set to zero to enable checking every time;
+		const auto check_interval = seconds(0);
+		if (duration_cast<seconds>(steady_clock::now() - file_abs->last_check_time) > check_interval) {
+			file_abs->last_check_time = steady_clock::now();
+			file_reopen(user_data);
+		}
+		FILE* file = to_file(user_data);
+		if (!file) {
+			return;
+		}
+#else
+		FILE* file = to_file(user_data);
+#endif
+		fwrite(line, 1, length, file);
+		if (g_flush_interval_ms == 0) {
+			fflush(file);
+		}
+	}
+
+	void file_close(void* user_data)
+	{
+		FILE* file = to_file(user_data);
+		if (file) {
+			fclose(file);
+		}
+#if LOGURU_WITH_FILEABS
+		delete reinterpret_cast<FileAbs*>(user_data);
+#endif
+	}
+
+	void file_flush(void* user_data)
+	{
+		FILE* file = to_file(user_data);
+		fflush(file);
+	}
+
+#if LOGURU_WITH_FILEABS
+	void file_reopen(void* user_data)
+	{
+		FileAbs * file_abs = reinterpret_cast<FileAbs*>(user_data);
+		struct stat st;
+		int ret;
+		if (!file_abs->fp || (ret = stat(file_abs->path, &st)) == -1 || (st.st_ino != file_abs->st.st_ino)) {
+			file_abs->is_reopening = true;
+			if (file_abs->fp) {
+				fclose(file_abs->fp);
+			}
+			if (!file_abs->fp) {
+				LOG_F(INFO, "Reopening file '%s' due to previous error", file_abs->path);
+			}
+			else if (ret < 0) {
+				const auto why = errno_as_text();
+				LOG_F(INFO, "Reopening file '%s' due to '%s'", file_abs->path, why.c_str());
+			} else {
+				LOG_F(INFO, "Reopening file '%s' due to file changed", file_abs->path);
+			}
+			// try reopen current file.
+			if (!create_directories(file_abs->path)) {
+				LOG_F(ERROR, "Failed to create directories to '%s'", file_abs->path);
+			}
+			file_abs->fp = fopen(file_abs->path, file_abs->mode_str);
+			if (!file_abs->fp) {
+				LOG_F(ERROR, "Failed to open '%s'", file_abs->path);
+			} else {
+				stat(file_abs->path, &file_abs->st);
+			}
+			file_abs->is_reopening = false;
+		}
+	}
+#endif
+	// ------------------------------------------------------------------------------
+	// Sparse timestamp index of a log file, see add_file and find_in_log.
+	// The .idx file is a magic string followed by IndexEntry:s in native byte order.
+
+	static const char s_index_magic[8] = {'L', 'G', 'R', 'I', 'D', 'X', '1', '\n'};
+
+	struct IndexEntry
+	{
+		long long timestamp_ns; // Of the line at offset, but never less than that of the previous entry.
+		long long offset;       // Of a line in the log file.
+	};
+
+	struct IndexedFile
+	{
+		void*     file;            // The user_data of the plain file sink.
+		FILE*     index;
+		unsigned  interval;
+		long long offset      = 0; // Where the next line goes in the log file.
+		long long next_offset = 0; // Index the first line at or after this offset...
+		long long next_ns     = 0; // ...or at or after this time.
+		long long last_ns     = 0;
+	};
+
+	void indexed_file_log(void* user_data, const Message& message, const char* line, size_t length)
+	{
+		auto indexed = reinterpret_cast<IndexedFile*>(user_data);
+		if (indexed->offset >= indexed->next_offset || message.timestamp_ns >= indexed->next_ns) {
+			const IndexEntry entry{std::max(message.timestamp_ns, indexed->last_ns), indexed->offset};
+			fwrite(&entry, sizeof(entry), 1, indexed->index);
+			if (g_flush_interval_ms == 0) {
+				fflush(indexed->index);
+			}
+			indexed->last_ns     = entry.timestamp_ns;
+			indexed->next_offset = indexed->offset + indexed->interval;
+			indexed->next_ns     = entry.timestamp_ns + 1000 * 1000 * 1000;
+		}
+		file_log(indexed->file, message, line, length);
+		indexed->offset += static_cast<long long>(length);
+	}
+
+	void indexed_file_close(void* user_data)
+	{
+		auto indexed = reinterpret_cast<IndexedFile*>(user_data);
+		file_close(indexed->file);
+		fclose(indexed->index);
+		delete indexed;
+	}
+
+	void indexed_file_flush(void* user_data)
+	{
+		auto indexed = reinterpret_cast<IndexedFile*>(user_data);
+		file_flush(indexed->file);
+		fflush(indexed->index);
+	}
+
+	static bool search_index(const char* data, size_t size, long long begin_ns, long long end_ns,
+	                         long long* begin_offset, long long* end_offset)
+	{
+		if (size < sizeof(s_index_magic) || memcmp(data, s_index_magic, sizeof(s_index_magic)) != 0) {
+			return false;
+		}
+		const char* entries = data + sizeof(s_index_magic);
+		const size_t num_entries = (size - sizeof(s_index_magic)) / sizeof(IndexEntry);
+		const auto entry_at = [entries](size_t i) {
+			IndexEntry entry;
+			memcpy(&entry, entries + i * sizeof(IndexEntry), sizeof(entry));
+			return entry;
+		};
+		// Index of the first entry with a timestamp above timestamp_ns (or at it, if !inclusive).
+		const auto upper_bound = [&](long long timestamp_ns, bool inclusive) {
+			size_t lo = 0, hi = num_entries;
+			while (lo < hi) {
+				const size_t mid = lo + (hi - lo) / 2;
+				const long long ts = entry_at(mid).timestamp_ns;
+				if (ts < timestamp_ns || (inclusive && ts == timestamp_ns)) {
+					lo = mid + 1;
+				} else {
+					hi = mid;
+				}
+			}
+			return lo;
+		};
+		const size_t first = upper_bound(begin_ns, false);
+		*begin_offset = first == 0 ? 0 : entry_at(first - 1).offset;
+		const size_t last = upper_bound(end_ns, true);
+		*end_offset = last == num_entries ? -1 : entry_at(last).offset;
+		return true;
+	}
+
+	bool find_in_log(const char* log_path, long long begin_ns, long long end_ns,
+	                 long long* begin_offset, long long* end_offset)
+	{
+		const std::string index_path = std::string(log_path) + ".idx";
+#ifdef _MSC_VER
+		FILE* file = fopen(index_path.c_str(), "rb");
+		if (!file) {
+			return false;
+		}
+		std::string data;
+		char buff[4096];
+		size_t num_read;
+		while ((num_read = fread(buff, 1, sizeof(buff), file)) > 0) {
+			data.append(buff, num_read);
+		}
+		fclose(file);
+		return search_index(data.data(), data.size(), begin_ns, end_ns, begin_offset, end_offset);
+#else
+		const int fd = open(index_path.c_str(), O_RDONLY);
+		if (fd == -1) {
+			return false;
+		}
+		struct stat st;
+		if (fstat(fd, &st) == -1 || st.st_size == 0) {
+			close(fd);
+			return false;
+		}
+		const size_t size = static_cast<size_t>(st.st_size);
+		void* data = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+		close(fd);
+		if (data == MAP_FAILED) {
+			return false;
+		}
+		const bool found = search_index(static_cast<const char*>(data), size, begin_ns, end_ns,
+		                                begin_offset, end_offset);
+		munmap(data, size);
+		return found;
+#endif
+	}
+
+	// ------------------------------------------------------------------------------
+	// Shared file sink (FileMode AppendShared):
+
+#ifndef _WIN32
+	struct SharedFile
+	{
+		int           fd;
+		std::string   pending;       // Complete records, at most LOGURU_SHARED_WRITE_SIZE bytes.
+		unsigned long num_split = 0; // Records split into pieces, for the serial in their frames.
+	};
+
+	// One write to an O_APPEND file is not interleaved with the writes of other processes.
+	static void shared_file_write(int fd, const char* data, size_t size)
+	{
+		while (size > 0) {
+			const ssize_t num_written = write(fd, data, size);
+			if (num_written < 0) {
+				if (errno == EINTR) { continue; }
+				return;
+			}
+			data += num_written;
+			size -= static_cast<size_t>(num_written);
+		}
+	}
+
+	static void shared_file_send(SharedFile* file)
+	{
+		shared_file_write(file->fd, file->pending.data(), file->pending.size());
+		file->pending.clear();
+	}
+
+	void shared_file_log(void* user_data, const Message&, const char* line, size_t length)
+	{
+		auto file = reinterpret_cast<SharedFile*>(user_data);
+		if (file->pending.size() + length > LOGURU_SHARED_WRITE_SIZE) {
+			shared_file_send(file);
+		}
+		if (length <= LOGURU_SHARED_WRITE_SIZE) {
+			file->pending.append(line, length);
+			return;
+		}
+
+		// Too big for one write: send it in framed pieces, see FileMode.
+		// Each piece gets its own newline, so drop the one ending the record.
+		if (line[length - 1] == '\n') { --length; }
+		const size_t piece_size = LOGURU_SHARED_WRITE_SIZE - 64; // Room for the frame.
+		const size_t num_pieces = (length + piece_size - 1) / piece_size;
+		const unsigned long serial = ++file->num_split;
+		for (size_t i = 0; i < num_pieces; ++i) {
+			const size_t begin = i * piece_size;
+			const size_t size = std::min(piece_size, length - begin);
+			char frame[64];
+			const int frame_length = snprintf(frame, sizeof(frame), "[%d.%lu %u/%u %u] ", static_cast<int>(getpid()), serial,
+			                                  static_cast<unsigned>(i + 1), static_cast<unsigned>(num_pieces), static_cast<unsigned>(size));
+			file->pending.assign(frame, static_cast<size_t>(frame_length));
+			file->pending.append(line + begin, size);
+			file->pending += '\n';
+			shared_file_send(file);
+		}
+	}
+
+	void shared_file_flush(void* user_data)
+	{
+		shared_file_send(reinterpret_cast<SharedFile*>(user_data));
+	}
+
+	void shared_file_close(void* user_data)
+	{
+		auto file = reinterpret_cast<SharedFile*>(user_data);
+		shared_file_send(file);
+		close(file->fd);
+		delete file;
+	}
+#endif // !_WIN32
+
+	// ------------------------------------------------------------------------------
+	// Socket sink:
+
+#ifndef _WIN32
+	struct SocketSink
+	{
+		std::string         path;
+		SocketProtocol      protocol;
+		int                 fd         = -1;
+		bool                is_stream  = false;
+		bool                connecting = false; // Non-blocking connect still in progress.
+		steady_clock::time_point next_connect;  // No reconnect attempts before this.
+		std::string         pending;     // Records not yet sent.
+		std::vector<size_t> record_ends; // End offset of each record in 'pending' (datagram boundaries).
+		size_t              first_sent = 0; // Stream: bytes of the first record sent on this connection.
+		std::string         scratch;
+		size_t              num_dropped = 0;
+	};
+
+	static bool socket_address(const SocketSink* sink, sockaddr_un* addr)
+	{
+		memset(addr, 0, sizeof(*addr));
+		addr->sun_family = AF_UNIX;
+		if (sink->path.size() >= sizeof(addr->sun_path)) {
+			return false;
+		}
+		memcpy(addr->sun_path, sink->path.c_str(), sink->path.size());
+		return true;
+	}
+
+	static bool socket_try_connect(SocketSink* sink)
+	{
+		sockaddr_un addr;
+		if (!socket_address(sink, &addr)) {
+			return false;
+		}
+
+		for (int type : { SOCK_DGRAM, SOCK_STREAM }) {
+			if (type == SOCK_STREAM && sink->protocol == Journald) {
+				break;
+			}
+			int fd = socket(AF_UNIX, type, 0);
+			if (fd == -1) {
+				return false;
+			}
+			// Non-blocking before connect, so a busy receiver can never stall the logging thread.
+			fcntl(fd, F_SETFL, fcntl(fd, F_GETFL) | O_NONBLOCK);
+			fcntl(fd, F_SETFD, FD_CLOEXEC);
+			const int result = connect(fd, reinterpret_cast<sockaddr*>(&addr), sizeof(addr));
+			// EAGAIN: the backlog of the receiver is full. Try again later, like EINPROGRESS.
+			if (result == 0 || errno == EINPROGRESS || errno == EAGAIN) {
+				sink->fd = fd;
+				sink->is_stream = (type == SOCK_STREAM);
+				sink->connecting = (result != 0);
+				return true;
+			}
+			const bool wrong_type = (errno == EPROTOTYPE);
+			close(fd);
+			if (!wrong_type) {
+				return false;
+			}
+		}
+		return false;
+	}
+
+	// On failure no new attempt is made for LOGURU_SOCKET_RETRY_MS.
+	static bool socket_connect(SocketSink* sink)
+	{
+		const auto now = steady_clock::now();
+		if (now < sink->next_connect) {
+			errno = EAGAIN;
+			return false;
+		}
+		if (socket_try_connect(sink)) {
+			return true;
+		}
+		const int error = errno;
+		sink->next_connect = now + milliseconds(LOGURU_SOCKET_RETRY_MS);
+		errno = error;
+		return false;
+	}
+
+	// A partly sent record is sent again from its beginning on the next connection.
+	static void socket_disconnect(SocketSink* sink)
+	{
+		if (sink->fd != -1) {
+			close(sink->fd);
+			sink->fd = -1;
+			sink->connecting = false;
+			sink->first_sent = 0;
+		}
+	}
+
+	// The receiver went away: wait LOGURU_SOCKET_RETRY_MS before trying to reconnect.
+	static void socket_lost(SocketSink* sink)
+	{
+		socket_disconnect(sink);
+		sink->next_connect = steady_clock::now() + milliseconds(LOGURU_SOCKET_RETRY_MS);
+	}
+
+	// Returns true once a non-blocking connect is through. On failure the sink is lost.
+	static bool socket_finish_connect(SocketSink* sink)
+	{
+		// Asking again works both for a connect in progress and for one refused with EAGAIN:
+		sockaddr_un addr;
+		socket_address(sink, &addr);
+		if (connect(sink->fd, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) == 0 || errno == EISCONN) {
+			sink->connecting = false;
+			return true;
+		}
+		if (errno != EINPROGRESS && errno != EALREADY && errno != EAGAIN && errno != EINTR) {
+			socket_lost(sink);
+		}
+		return false;
+	}
+
+	static void socket_append_field(std::string& out, const char* key, const char* value)
+	{
+		if (strchr(value, '\n')) {
+			// Binary-safe form: KEY\n<64-bit little endian length><data>\n
+			out += key;
+			out += '\n';
+			uint64_t length = strlen(value);
+			for (int i = 0; i < 8; ++i) {
+				out += static_cast<char>((length >> (8 * i)) & 0xff);
+			}
+			out += value;
+		} else {
+			out += key;
+			out += '=';
+			out += value;
+		}
+		out += '\n';
+	}
+
+	static int journald_priority(Verbosity verbosity)
+	{
+		if (verbosity <= Verbosity_FATAL)   { return 2; } // LOG_CRIT
+		if (verbosity == Verbosity_ERROR)   { return 3; } // LOG_ERR
+		if (verbosity == Verbosity_WARNING) { return 4; } // LOG_WARNING
+		if (verbosity == Verbosity_INFO)    { return 6; } // LOG_INFO
+		return 7;                                         // LOG_DEBUG
+	}
+
+	// Returns false if the receiver is stalled (or gone) and records remain.
+	static bool socket_send(SocketSink* sink)
+	{
+		if (sink->record_ends.empty()) {
+			return true;
+		}
+		if (sink->fd == -1 && !socket_connect(sink)) {
+			return false;
+		}
+		if (sink->connecting && !socket_finish_connect(sink)) {
+			return false;
+		}
+
+		size_t num_sent_bytes = 0;
+		bool ok = true;
+
+		if (sink->is_stream) {
+			size_t offset = sink->first_sent;
+			while (offset < sink->pending.size()) {
+				auto result = send(sink->fd, sink->pending.data() + offset,
+								   sink->pending.size() - offset, MSG_NOSIGNAL | MSG_DONTWAIT);
+				if (result < 0) {
+					if (errno == EINTR) { continue; }
+					if (errno != EAGAIN && errno != EWOULDBLOCK) { socket_lost(sink); }
+					ok = false;
+					break;
+				}
+				offset += static_cast<size_t>(result);
+			}
+			// Only whole records leave 'pending', so a new receiver never gets the tail of one:
+			for (size_t end : sink->record_ends) {
+				if (end > offset) { break; }
+				num_sent_bytes = end;
+			}
+			sink->first_sent = sink->fd == -1 ? 0 : offset - num_sent_bytes;
+		} else {
+			size_t num_sent_records = 0;
+			while (num_sent_records < sink->record_ends.size()) {
+	#ifdef __linux__
+				// Send up to 64 datagrams per system call.
+				const size_t MAX_BATCH = 64;
+				mmsghdr messages[MAX_BATCH];
+				iovec   iovecs[MAX_BATCH];
+				size_t num_batch = 0;
+				size_t begin = num_sent_bytes;
+				for (size_t i = num_sent_records; i < sink->record_ends.size() && num_batch < MAX_BATCH; ++i) {
+					iovecs[num_batch].iov_base = &sink->pending[begin];
+					iovecs[num_batch].iov_len  = sink->record_ends[i] - begin;
+					memset(&messages[num_batch], 0, sizeof(mmsghdr));
+					messages[num_batch].msg_hdr.msg_iov    = &iovecs[num_batch];
+					messages[num_batch].msg_hdr.msg_iovlen = 1;
+					begin = sink->record_ends[i];
+					++num_batch;
+				}
+				int result = sendmmsg(sink->fd, messages, static_cast<unsigned>(num_batch), MSG_NOSIGNAL | MSG_DONTWAIT);
+	#else
+				auto result = send(sink->fd, sink->pending.data() + num_sent_bytes,
+								   sink->record_ends[num_sent_records] - num_sent_bytes, MSG_DONTWAIT);
+				if (result >= 0) { result = 1; }
+	#endif
+				if (result < 0) {
+					if (errno == EINTR) { continue; }
+					if (errno == EMSGSIZE) {
+						// Too big for a datagram - count it as dropped and carry on.
+						++sink->num_dropped;
+						num_sent_bytes = sink->record_ends[num_sent_records++];
+						continue;
+					}
+					if (errno != EAGAIN && errno != EWOULDBLOCK) { socket_lost(sink); }
+					ok = false;
+					break;
+				}
+				num_sent_records += static_cast<size_t>(result);
+				num_sent_bytes = sink->record_ends[num_sent_records - 1];
+			}
+		}
+
+		sink->pending.erase(0, num_sent_bytes);
+		size_t num_done = 0;
+		while (num_done < sink->record_ends.size() && sink->record_ends[num_done] <= num_sent_bytes) {
+			++num_done;
+		}
+		sink->record_ends.erase(sink->record_ends.begin(), sink->record_ends.begin() + static_cast<std::ptrdiff_t>(num_done));
+		for (auto& end : sink->record_ends) {
+			end -= num_sent_bytes;
+		}
+		return ok;
+	}
+
+	void socket_log(void* user_data, const Message& message, const char* line, size_t length)
+	{
+		auto sink = reinterpret_cast<SocketSink*>(user_data);
+		const auto old_size = sink->pending.size();
+
+		if (sink->protocol == Journald) {
+			char priority[8], line_str[16], verbosity_str[8];
+			snprintf(priority,      sizeof(priority),      "%d", journald_priority(message.verbosity));
+			snprintf(line_str,      sizeof(line_str),      "%u", message.line);
+			snprintf(verbosity_str, sizeof(verbosity_str), "%d", message.verbosity);
+			sink->scratch.clear();
+			sink->scratch += message.indentation;
+			sink->scratch += message.context;
+			sink->scratch += message.prefix;
+			sink->scratch += message.message;
+			socket_append_field(sink->pending, "PRIORITY",         priority);
+			socket_append_field(sink->pending, "MESSAGE",          sink->scratch.c_str());
+			socket_append_field(sink->pending, "CODE_FILE",        message.filename);
+			socket_append_field(sink->pending, "CODE_LINE",        line_str);
+			socket_append_field(sink->pending, "LOGURU_VERBOSITY", verbosity_str);
+			if (message.sample_rate > 1) {
+				char sample_rate_str[16];
+				snprintf(sample_rate_str, sizeof(sample_rate_str), "%u", message.sample_rate);
+				socket_append_field(sink->pending, "LOGURU_SAMPLE_RATE", sample_rate_str);
+			}
+			if (!s_argv0_filename.empty()) {
+				socket_append_field(sink->pending, "SYSLOG_IDENTIFIER", s_argv0_filename.c_str());
+			}
+		} else {
+			sink->pending.append(line, length);
+		}
+
+		if (sink->pending.size() > LOGURU_SOCKET_SPILL_SIZE) {
+			// Receiver is stalled and we are out of spill space.
+			sink->pending.resize(old_size);
+			++sink->num_dropped;
+			return;
+		}
+		sink->record_ends.push_back(sink->pending.size());
+
+		if (sink->pending.size() >= LOGURU_SOCKET_BATCH_SIZE) {
+			socket_send(sink);
+		}
+	}
+
+	void socket_flush(void* user_data)
+	{
+		auto sink = reinterpret_cast<SocketSink*>(user_data);
+		if (!socket_send(sink) || sink->num_dropped == 0) {
+			return;
+		}
+		// Receiver caught up: tell it what it missed.
+		auto note = textprintf("loguru: socket '%s' dropped %llu records", sink->path.c_str(),
+							   static_cast<unsigned long long>(sink->num_dropped));
+		sink->num_dropped = 0;
+		if (sink->protocol == Journald) {
+			socket_append_field(sink->pending, "PRIORITY", "4");
+			socket_append_field(sink->pending, "MESSAGE",  note.c_str());
+		} else {
+			sink->pending += note.c_str();
+			sink->pending += '\n';
+		}
+		sink->record_ends.push_back(sink->pending.size());
+		socket_send(sink);
+	}
+
+	void socket_close(void* user_data)
+	{
+		auto sink = reinterpret_cast<SocketSink*>(user_data);
+		socket_send(sink);
+		socket_disconnect(sink);
+		delete sink;
+	}
+#endif // !_WIN32
+
+	// ------------------------------------------------------------------------------
+
+	// Helpers:
+
+	Text::~Text()
+	{
+		if (_scratch_in_use) {
+			*_scratch_in_use = false;
+		} else if (_str != _inline) {
+			free(_str);
+		}
+	}
+
+	Text::Text(Text&& t) : _str(t._str), _scratch_in_use(t._scratch_in_use)
+	{
+		if (t._str == t._inline) {
+			memcpy(_inline, t._inline, sizeof(_inline));
+			_str = _inline;
+		}
+		t._str = nullptr;
+		t._scratch_in_use = nullptr;
+	}
+
+	char* Text::release()
+	{
+		char* result = _str;
+		if (_str && (_str == _inline || _scratch_in_use)) {
+			result = strdup(_str);
+			if (_scratch_in_use) { *_scratch_in_use = false; }
+		}
+		_str = nullptr;
+		_scratch_in_use = nullptr;
+		return result;
+	}
+
+	Text Text::copy(const char* str)
+	{
+		const size_t size = strlen(str) + 1;
+		if (size <= LOGURU_TEXT_INLINE_SIZE) {
+			Text result;
+			memcpy(result._inline, str, size);
+			return result;
+		}
+		return Text(strdup(str));
+	}
+
+	// Formats into the inline buffer of a Text, or a given scratch buffer, or else the heap.
+	struct TextBuilder
+	{
+		LOGURU_PRINTF_LIKE(3, 0)
+		static Text vformat(bool* scratch_in_use, char* scratch, const char* format, va_list vlist)
+		{
+			Text result;
+			char*  buff = result._inline;
+			size_t buff_size = sizeof(result._inline);
+			if (scratch_in_use && !*scratch_in_use) {
+				buff = scratch;
+				buff_size = LOGURU_SCRATCH_SIZE;
+			}
+
+			va_list vlist_copy;
+			va_copy(vlist_copy, vlist);
+			const int bytes_needed = vsnprintf(buff, buff_size, format, vlist_copy);
+			va_end(vlist_copy);
+			CHECK_F(bytes_needed >= 0, "Bad string format: '%s'", format);
+
+			if (static_cast<size_t>(bytes_needed) < buff_size) {
+				if (buff == scratch) {
+					*scratch_in_use = true;
+					result._scratch_in_use = scratch_in_use;
+					result._str = scratch;
+				}
+				return result;
+			}
+
+			char* heap_buff = static_cast<char*>(malloc(bytes_needed + 1));
+			vsnprintf(heap_buff, bytes_needed + 1, format, vlist);
+			result._str = heap_buff;
+			return result;
+		}
+	};
+
+	LOGURU_PRINTF_LIKE(1, 0)
+	static Text vtextprintf(const char* format, va_list vlist)
+	{
+		return TextBuilder::vformat(nullptr, nullptr, format, vlist);
+	}
+
+	/*  For the message text while logging: formatted in a per-thread scratch buffer.
+		Only one such Text may be alive per thread; if a message is logged while formatting
+		another (e.g. from a format_value), the inner one falls back to vtextprintf. */
+	LOGURU_PRINTF_LIKE(1, 0)
+	static Text vtextprintf_scratch(const char* format, va_list vlist)
+	{
+		struct Scratch
+		{
+			bool in_use = false;
+			char buff[LOGURU_SCRATCH_SIZE];
+		};
+		static thread_local Scratch s_scratch;
+		return TextBuilder::vformat(&s_scratch.in_use, s_scratch.buff, format, vlist);
+	}
+
+	Text textprintf(const char* format, ...)
+	{
+		va_list vlist;
+		va_start(vlist, format);
+		auto result = vtextprintf(format, vlist);
+		va_end(vlist);
+		return result;
+	}
+
+	// Overloaded for variadic template matching.
+	Text textprintf()
+	{
+		return Text::copy("");
+	}
+
+	static const char* indentation(unsigned depth)
+	{
+		static const char buff[] =
+		".   .   .   .   .   .   .   .   .   .   " ".   .   .   .   .   .   .   .   .   .   "
+		".   .   .   .   .   .   .   .   .   .   " ".   .   .   .   .   .   .   .   .   .   "
+		".   .   .   .   .   .   .   .   .   .   " ".   .   .   .   .   .   .   .   .   .   "
+		".   .   .   .   .   .   .   .   .   .   " ".   .   .   .   .   .   .   .   .   .   "
+		".   .   .   .   .   .   .   .   .   .   " ".   .   .   .   .   .   .   .   .   .   ";
+		static const size_t INDENTATION_WIDTH = 4;
+		static const size_t NUM_INDENTATIONS = (sizeof(buff) - 1) / INDENTATION_WIDTH;
+		depth = std::min<unsigned>(depth, NUM_INDENTATIONS);
+		return buff + INDENTATION_WIDTH * (NUM_INDENTATIONS - depth);
+	}
+
+	// The open LOG_SCOPE_Fs, as of when a message was logged. Async records carry a copy,
+	// so they are indented as they would have been if written right away.
+	const int NUM_SCOPE_VERBOSITIES = Verbosity_MAX - Verbosity_OFF + 1;
+
+	struct ScopeDepths
+	{
+		unsigned stderr_depth;
+		uint8_t  by_verbosity[NUM_SCOPE_VERBOSITIES]; // Open scopes of each verbosity, from Verbosity_OFF up.
+	};
+
+	static std::atomic<uint8_t> s_open_scopes[NUM_SCOPE_VERBOSITIES];
+
+	static int scope_verbosity_index(Verbosity verbosity)
+	{
+		return std::min(std::max(verbosity - Verbosity_OFF, 0), NUM_SCOPE_VERBOSITIES - 1);
+	}
+
+	static void current_scope_depths(ScopeDepths* out)
+	{
+		out->stderr_depth = s_stderr_indentation.load(std::memory_order_relaxed);
+		for (int i = 0; i < NUM_SCOPE_VERBOSITIES; ++i) {
+			out->by_verbosity[i] = s_open_scopes[i].load(std::memory_order_relaxed);
+		}
+	}
+
+	// A sink is indented by the open scopes within its verbosity.
+	static unsigned sink_depth(const ScopeDepths& depths, Verbosity verbosity)
+	{
+		if (verbosity < Verbosity_OFF) { return 0; }
+		unsigned depth = 0;
+		for (int i = 0; i <= scope_verbosity_index(verbosity); ++i) {
+			depth += depths.by_verbosity[i];
+		}
+		return depth;
+	}
+
+	// Parses an integer, or one of OFF, INFO, WARNING, ERROR, FATAL.
+	static bool parse_verbosity(const char* value_str, Verbosity* out_verbosity)
+	{
+		if (strcmp(value_str, "OFF") == 0) {
+			*out_verbosity = Verbosity_OFF;
+		} else if (strcmp(value_str, "INFO") == 0) {
+			*out_verbosity = Verbosity_INFO;
+		} else if (strcmp(value_str, "WARNING") == 0) {
+			*out_verbosity = Verbosity_WARNING;
+		} else if (strcmp(value_str, "ERROR") == 0) {
+			*out_verbosity = Verbosity_ERROR;
+		} else if (strcmp(value_str, "FATAL") == 0) {
+			*out_verbosity = Verbosity_FATAL;
+		} else {
+			char* end = 0;
+			long value = strtol(value_str, &end, 10);
+			if (end == value_str || !end || *end != '\0') {
+				return false;
+			}
+			*out_verbosity = static_cast<Verbosity>(value);
+		}
+		return true;
+	}
+
+	static void parse_args(int& argc, char* argv[], const char* verbosity_flag)
+	{
+		int arg_dest = 1;
+		int out_argc = argc;
+
+		for (int arg_it = 1; arg_it < argc; ++arg_it) {
+			auto cmd = argv[arg_it];
+			auto arg_len = strlen(verbosity_flag);
+			if (strncmp(cmd, verbosity_flag, arg_len) == 0 && !std::isalpha(cmd[arg_len], std::locale(""))) {
+				out_argc -= 1;
+				auto value_str = cmd + arg_len;
+				if (value_str[0] == '\0') {
+					// Value in separate argument
+					arg_it += 1;
+					CHECK_LT_F(arg_it, argc, "Missing verbosiy level after %s", verbosity_flag);
+					value_str = argv[arg_it];
+					out_argc -= 1;
+				}
+				if (*value_str == '=') { value_str += 1; }
+
+				Verbosity verbosity;
+				CHECK_F(parse_verbosity(value_str, &verbosity),
+					"Invalid verbosity. Expected integer, INFO, WARNING, ERROR or OFF, got '%s'", value_str);
+				g_stderr_verbosity = verbosity;
+			} else {
+				argv[arg_dest++] = argv[arg_it];
+			}
+		}
+
+		argc = out_argc;
+		argv[argc] = nullptr;
+	}
+
+	// ------------------------------------------------------------------------------
+	// Clocks:
+
+	// Time of a log message, read once from the selected clock.
+	struct Timestamp
+	{
+		long long epoch_ns;  // Since epoch.
+		long long uptime_ns; // Since start. Zero if not asked for.
+	};
+
+	static std::atomic<int> s_clock_mode { Clock_System };
+
+	static long long system_epoch_ns()
+	{
+		return duration_cast<nanoseconds>(system_clock::now().time_since_epoch()).count();
+	}
+
+	static long long steady_uptime_ns()
+	{
+		return duration_cast<nanoseconds>(steady_clock::now() - s_start_time).count();
+	}
+
+	static const long long s_start_epoch_ns = system_epoch_ns();
+
+#ifdef CLOCK_REALTIME_COARSE
+	#define LOGURU_HAS_COARSE_CLOCK 1
+
+	static long long coarse_epoch_ns()
+	{
+		timespec ts;
+		clock_gettime(CLOCK_REALTIME_COARSE, &ts);
+		return static_cast<long long>(ts.tv_sec) * 1000000000LL + ts.tv_nsec;
+	}
+#else
+	#define LOGURU_HAS_COARSE_CLOCK 0
+#endif
+
+#if (defined(__x86_64__) || defined(__i386__)) && (defined(__GNUC__) || defined(__clang__)) && LOGURU_HAS_COARSE_CLOCK
+	#define LOGURU_HAS_TSC 1
+
+	static long long realtime_epoch_ns()
+	{
+		timespec ts;
+		clock_gettime(CLOCK_REALTIME, &ts);
+		return static_cast<long long>(ts.tv_sec) * 1000000000LL + ts.tv_nsec;
+	}
+
+	static bool has_invariant_tsc()
+	{
+		unsigned eax, ebx, ecx, edx;
+		if (!__get_cpuid(0x80000007, &eax, &ebx, &ecx, &edx)) {
+			return false;
+		}
+		return (edx & (1u << 8)) != 0;
+	}
+
+	/*  TSC ticks are mapped to epoch ns with a linear anchor (tsc, epoch_ns, ns_per_tick).
+		The anchor is re-synced against CLOCK_REALTIME every second by whichever thread notices,
+		and published with a seqlock so readers never block.
+		The calibration is immutable once published; set_clock_mode publishes a new one. */
+	struct TscCalibration
+	{
+		long long tsc;          // Start of the baseline for re-syncs.
+		long long epoch_ns;
+		long long start_tsc;    // Tick count at s_start_epoch_ns, for uptime.
+		long long resync_ticks;
+	};
+
+	struct TscClock
+	{
+		std::atomic<unsigned>  seq { 0 };
+		std::atomic<bool>      resyncing { false }; // Also held while publishing a new calibration.
+		std::atomic<long long> anchor_tsc { 0 };
+		std::atomic<long long> anchor_epoch_ns { 0 };
+		std::atomic<double>    ns_per_tick { 1.0 };
+		std::atomic<const TscCalibration*> calibration { nullptr }; // Old ones are leaked: readers may hold them.
+	};
+
+	static TscClock s_tsc;
+
+	static void tsc_publish(long long tsc, long long epoch_ns, double ns_per_tick)
+	{
+		s_tsc.seq.fetch_add(1, std::memory_order_acq_rel); // Odd: writing.
+		s_tsc.anchor_tsc.store(tsc, std::memory_order_relaxed);
+		s_tsc.anchor_epoch_ns.store(epoch_ns, std::memory_order_relaxed);
+		s_tsc.ns_per_tick.store(ns_per_tick, std::memory_order_relaxed);
+		s_tsc.seq.fetch_add(1, std::memory_order_release); // Even: done.
+	}
+
+	static void tsc_calibrate()
+	{
+		const long long tsc_0 = static_cast<long long>(__rdtsc());
+		const long long ns_0 = realtime_epoch_ns();
+		std::this_thread::sleep_for(std::chrono::milliseconds(10));
+		const long long tsc_1 = static_cast<long long>(__rdtsc());
+		const long long ns_1 = realtime_epoch_ns();
+
+		const double ns_per_tick = static_cast<double>(ns_1 - ns_0) / static_cast<double>(tsc_1 - tsc_0);
+		auto calibration = new TscCalibration();
+		calibration->tsc = tsc_0;
+		calibration->epoch_ns = ns_0;
+		calibration->start_tsc = tsc_0 - static_cast<long long>(static_cast<double>(ns_0 - s_start_epoch_ns) / ns_per_tick);
+		calibration->resync_ticks = static_cast<long long>(1e9 / ns_per_tick); // Every second.
+
+		// Only one writer of the seqlock at a time:
+		while (s_tsc.resyncing.exchange(true, std::memory_order_acquire)) {
+			std::this_thread::yield();
+		}
+		s_tsc.calibration.store(calibration, std::memory_order_release);
+		tsc_publish(tsc_1, ns_1, ns_per_tick);
+		s_tsc.resyncing.store(false, std::memory_order_release);
+	}
+
+	static void tsc_resync(long long tsc)
+	{
+		if (s_tsc.resyncing.exchange(true, std::memory_order_acquire)) {
+			return; // Someone else is on it.
+		}
+		const TscCalibration* calibration = s_tsc.calibration.load(std::memory_order_acquire);
+		const long long epoch_ns = realtime_epoch_ns();
+		// The longer the baseline, the better the estimate of the tick rate:
+		const double ns_per_tick = static_cast<double>(epoch_ns - calibration->epoch_ns) /
+								   static_cast<double>(tsc - calibration->tsc);
+		if (ns_per_tick > 0) {
+			tsc_publish(tsc, epoch_ns, ns_per_tick);
+		}
+		s_tsc.resyncing.store(false, std::memory_order_release);
+	}
+
+	static Timestamp tsc_now()
+	{
+		const long long tsc = static_cast<long long>(__rdtsc());
+		const TscCalibration* calibration = s_tsc.calibration.load(std::memory_order_acquire);
+		if (!calibration) {
+			// Saw the clock mode before the calibration:
+			return Timestamp{system_epoch_ns(), steady_uptime_ns()};
+		}
+		long long anchor_tsc, anchor_epoch_ns;
+		double ns_per_tick;
+		unsigned seq;
+		do {
+			seq = s_tsc.seq.load(std::memory_order_acquire);
+			anchor_tsc      = s_tsc.anchor_tsc.load(std::memory_order_relaxed);
+			anchor_epoch_ns = s_tsc.anchor_epoch_ns.load(std::memory_order_relaxed);
+			ns_per_tick     = s_tsc.ns_per_tick.load(std::memory_order_relaxed);
+			std::atomic_thread_fence(std::memory_order_acquire);
+		} while ((seq & 1) != 0 || seq != s_tsc.seq.load(std::memory_order_relaxed));
+
+		if (tsc - anchor_tsc > calibration->resync_ticks) {
+			tsc_resync(tsc);
+		}
+		const long long epoch_ns = anchor_epoch_ns + static_cast<long long>(static_cast<double>(tsc - anchor_tsc) * ns_per_tick);
+		const long long uptime_ns = static_cast<long long>(static_cast<double>(tsc - calibration->start_tsc) * ns_per_tick);
+		return Timestamp{epoch_ns, uptime_ns};
+	}
+#else
+	#define LOGURU_HAS_TSC 0
+#endif
+
+	static Timestamp now_timestamp(bool with_uptime)
+	{
+		switch (s_clock_mode.load(std::memory_order_relaxed)) {
+	#if LOGURU_HAS_TSC
+		case Clock_TSC:
+			return tsc_now();
+	#endif
+	#if LOGURU_HAS_COARSE_CLOCK
+		case Clock_Coarse: {
+			const long long epoch_ns = coarse_epoch_ns();
+			// The coarse clock lags the precise one that s_start_epoch_ns came from by up to a tick:
+			return Timestamp{epoch_ns, std::max(epoch_ns - s_start_epoch_ns, 0LL)};
+		}
+	#endif
+		default:
+			return Timestamp{system_epoch_ns(), with_uptime ? steady_uptime_ns() : 0};
+		}
+	}
+
+	long long timestamp_ns()
+	{
+		return now_timestamp(false).epoch_ns;
+	}
+
+	// Monotonic (except in Clock_Coarse), for timing scopes.
+	static long long now_ns()
+	{
+		if (s_clock_mode.load(std::memory_order_relaxed) == Clock_System) {
+			return steady_uptime_ns();
+		}
+		return now_timestamp(true).uptime_ns;
+	}
+
+	static void install_fork_handlers();
+
+	ClockMode set_clock_mode(ClockMode mode)
+	{
+		if (mode == Clock_TSC) {
+	#if LOGURU_HAS_TSC
+			if (has_invariant_tsc()) {
+				install_fork_handlers(); // The child may need to publish a new anchor.
+				tsc_calibrate();
+				s_clock_mode = Clock_TSC;
+				LOG_F(INFO, "Clock: invariant TSC, %.4f ns per tick", s_tsc.ns_per_tick.load());
+				return Clock_TSC;
+			}
+	#endif
+			LOG_F(WARNING, "No invariant TSC available, using a coarse clock instead");
+			mode = Clock_Coarse;
+		}
+		if (mode == Clock_Coarse && !LOGURU_HAS_COARSE_CLOCK) {
+			LOG_F(WARNING, "No coarse clock available, using the system clock instead");
+			mode = Clock_System;
+		}
+		s_clock_mode = mode;
+		return mode;
+	}
+
+	// Returns the part of the path after the last / or \ (if any).
+	const char* filename(const char* path)
+	{
+		// strrchr is vectorized, unlike a loop over every character.
+		const char* slash = strrchr(path, '/');
+		if (slash) { path = slash + 1; }
+		const char* backslash = strrchr(path, '\\');
+		if (backslash) { path = backslash + 1; }
+		return path;
+	}
+
+	// ------------------------------------------------------------------------------
+	// Fork safety:
+
+#if LOGURU_PTHREADS
+	/*  fork() only copies the calling thread. Any lock held by another thread stays locked
+		forever in the child, and anything buffered but not yet written would be written twice.
+		So before forking we take our locks (no one is half-way through writing a message)
+		and flush the stdio buffers of our files. The parent and the child both let go again;
+		LogMutex allows that even if the forking thread held s_mutex already, e.g. when
+		forking from within a callback. What is still pending in memory (async records,
+		batches, shared file and socket buffers) is the parent's to write: the child drops it.
+		The child restarts our background threads lazily. */
+	static void lock_all_shards();
+	static void unlock_all_shards();
+	static void discard_async_records();
+
+	static void on_fork_prepare()
+	{
+		s_mutex.lock();
+		fflush(stderr);
+		for (const auto& callback : s_callbacks) {
+			if (callback.line_callback == file_log) {
+				if (FILE* file = to_file(callback.user_data)) { fflush(file); }
+			} else if (callback.line_callback == indexed_file_log) {
+				auto indexed = reinterpret_cast<IndexedFile*>(callback.user_data);
+				if (FILE* file = to_file(indexed->file)) { fflush(file); }
+				fflush(indexed->index);
+			}
+		}
+		lock_all_shards(); // So no async record is appended half-way.
+		s_async_wake_mutex.lock();
+		s_localtime_mutex.lock();
+	}
+
+	static void on_fork_parent()
+	{
+		s_localtime_mutex.unlock();
+		s_async_wake_mutex.unlock();
+		unlock_all_shards();
+		s_mutex.unlock();
+	}
+
+	static void on_fork_child()
+	{
+		s_localtime_mutex.unlock();
+		s_async_wake_mutex.unlock();
+		// Only the async thread ever waits on it, and it is gone:
+		new (&s_async_wake) std::condition_variable();
+		discard_async_records();
+		unlock_all_shards();
+		if (s_async_thread) {
+			s_async_thread = nullptr;
+			s_async_needs_thread = true;
+		}
+
+		for (const auto& callback : s_callbacks) {
+			if (callback.batch) {
+				callback.batch->pending.clear();
+			} else if (callback.line_callback == shared_file_log) {
+				reinterpret_cast<SharedFile*>(callback.user_data)->pending.clear();
+			} else if (callback.line_callback == socket_log) {
+				auto sink = reinterpret_cast<SocketSink*>(callback.user_data);
+				sink->pending.clear();
+				sink->record_ends.clear();
+				sink->first_sent = 0;
+			}
+		}
+
+		// The std::thread objects are leaked: destroying a joinable thread would terminate.
+		s_flush_thread = nullptr;
+		s_needs_flushing = false;
+		if (s_config_thread) {
+			s_config_thread = nullptr;
+			s_config_restart_needed = true;
+		}
+
+	#if LOGURU_HAS_TSC
+		// Another thread may have been in the middle of re-syncing the TSC anchor:
+		if (s_tsc.seq.load() & 1) {
+			s_tsc.seq.fetch_add(1);
+		}
+		s_tsc.resyncing = false;
+		if (s_clock_mode == Clock_TSC) {
+			tsc_publish(static_cast<long long>(__rdtsc()), realtime_epoch_ns(), s_tsc.ns_per_tick.load());
+		}
+	#endif
+
+		s_mutex.unlock();
+	}
+#endif // LOGURU_PTHREADS
+
+	// Called by init and whatever starts buffering or threads, so programs that never do pay nothing on fork.
+	static void install_fork_handlers()
+	{
+	#if LOGURU_PTHREADS
+		static const bool s_installed = pthread_atfork(on_fork_prepare, on_fork_parent, on_fork_child) == 0;
+		(void)s_installed;
+	#endif
+	}
+
+	// ------------------------------------------------------------------------------
+
+	static void on_atexit()
+	{
+		LOG_F(INFO, "atexit");
+		flush();
+	}
+
+	static void install_signal_handlers();
+
+	static void add_line_callback(const char* id, line_handler_t line_callback, void* user_data,
+								  Verbosity verbosity, close_handler_t on_close, flush_handler_t on_flush);
+
+	static void write_hex_digit(std::string& out, unsigned num)
+	{
+		DCHECK_LT_F(num, 16u);
+		if (num < 10u) { out.push_back(char('0' + num)); }
+		else { out.push_back(char('A' + num - 10)); }
+	}
+
+	static void write_hex_byte(std::string& out, uint8_t n)
+	{
+		write_hex_digit(out, n >> 4u);
+		write_hex_digit(out, n & 0x0f);
+	}
+
+	static void escape(std::string& out, const std::string& str)
+	{
+		for (char c : str) {
+			/**/ if (c == '\a') { out += "\\a";  }
+			else if (c == '\b') { out += "\\b";  }
+			else if (c == '\f') { out += "\\f";  }
+			else if (c == '\n') { out += "\\n";  }
+			else if (c == '\r') { out += "\\r";  }
+			else if (c == '\t') { out += "\\t";  }
+			else if (c == '\v') { out += "\\v";  }
+			else if (c == '\\') { out += "\\\\"; }
+			else if (c == '\'') { out += "\\\'"; }
+			else if (c == '\"') { out += "\\\""; }
+			else if (c == ' ')  { out += "\\ ";  }
+			else if (0 <= c && c < 0x20) { // ASCI control character:
+			// else if (c < 0x20 || c != (c & 127)) { // ASCII control character or UTF-8:
+				out += "\\x";
+				write_hex_byte(out, static_cast<uint8_t>(c));
+			} else { out += c; }
+		}
+	}
+
+	Text errno_as_text()
+	{
+		char buff[256];
+	#ifdef __linux__
+		return Text::copy(strerror_r(errno, buff, sizeof(buff)));
+	#elif __APPLE__
+		strerror_r(errno, buff, sizeof(buff));
+		return Text::copy(buff);
+	#elif _WIN32
+		strerror_s(buff, sizeof(buff), errno);
+		return Text::copy(buff);
+	#else
+		// Not thread-safe.
+		return Text::copy(strerror(errno));
+	#endif
+	}
+
+	void init(int& argc, char* argv[], const char* verbosity_flag)
+	{
+		CHECK_GT_F(argc,       0,       "Expected proper argc/argv");
+		CHECK_EQ_F(argv[argc], nullptr, "Expected proper argc/argv");
+
+		install_fork_handlers();
+		s_argv0_filename = filename(argv[0]);
+
+		#ifdef _WIN32
+			#define getcwd _getcwd
+		#endif
+
+		if (!getcwd(s_current_dir, sizeof(s_current_dir)))
+		{
+			const auto error_text = errno_as_text();
+			LOG_F(WARNING, "Failed to get current working directory: %s", error_text.c_str());
+		}
+
+		s_arguments = "";
+		for (int i = 0; i < argc; ++i) {
+			escape(s_arguments, argv[i]);
+			if (i + 1 < argc) {
+				s_arguments += " ";
+			}
+		}
+
+		if (verbosity_flag) {
+			parse_args(argc, argv, verbosity_flag);
+		}
+
+		#if LOGURU_PTLS_NAMES || LOGURU_WINTHREADS
+			set_thread_name("main thread");
+		#elif LOGURU_PTHREADS
+			char old_thread_name[16] = {0};
+			auto this_thread = pthread_self();
+			pthread_getname_np(this_thread, old_thread_name, sizeof(old_thread_name));
+			if (old_thread_name[0] == 0) {
+				#ifdef __APPLE__
+					pthread_setname_np("main thread");
+				#else
+					pthread_setname_np(this_thread, "main thread");
+				#endif
+			}
+		#endif // LOGURU_PTHREADS
+
+		if (g_stderr_verbosity >= Verbosity_INFO) {
+			if (g_colorlogtostderr && s_terminal_has_color) {
+				fprintf(stderr, "%s%s%s\n", terminal_reset(), terminal_dim(), preamble_explain());
+			} else {
+				fprintf(stderr, "%s\n", preamble_explain());
+			}
+			fflush(stderr);
+		}
+		LOG_F(INFO, "arguments: %s", s_arguments.c_str());
+		if (strlen(s_current_dir) != 0)
+		{
+			LOG_F(INFO, "Current dir: %s", s_current_dir);
+		}
+		LOG_F(INFO, "stderr verbosity: %d", g_stderr_verbosity);
+		LOG_F(INFO, "-----------------------------------");
+
+		install_signal_handlers();
+
+		atexit(on_atexit);
+	}
+
+	void shutdown()
+	{
+		LOG_F(INFO, "loguru::shutdown()");
+		unwatch_verbosity_config();
+		remove_all_callbacks();
+		set_fatal_handler(nullptr);
+	}
+
+	static void local_time(time_t sec_since_epoch, tm* out_time_info)
+	{
+		// Most messages are logged in the same second as the previous one from the same thread:
+		struct Cache { time_t sec; tm time_info; };
+		static thread_local Cache s_cache = { time_t(-1), tm() };
+		if (s_cache.sec != sec_since_epoch) {
+			std::lock_guard<std::mutex> lock(s_localtime_mutex);
+			localtime_r(&sec_since_epoch, &s_cache.time_info);
+			s_cache.sec = sec_since_epoch;
+		}
+		*out_time_info = s_cache.time_info;
+	}
+
+	void write_date_time(char* buff, size_t buff_size)
+	{
+		auto now = system_clock::now();
+		long long ms_since_epoch = duration_cast<milliseconds>(now.time_since_epoch()).count();
+		time_t sec_since_epoch = time_t(ms_since_epoch / 1000);
+		tm time_info;
+		local_time(sec_since_epoch, &time_info);
+		snprintf(buff, buff_size, "%04d%02d%02d_%02d%02d%02d.%03lld",
+			1900 + time_info.tm_year, 1 + time_info.tm_mon, time_info.tm_mday,
+			time_info.tm_hour, time_info.tm_min, time_info.tm_sec, ms_since_epoch % 1000);
+	}
+
+	const char* argv0_filename()
+	{
+		return s_argv0_filename.c_str();
+	}
+
+	const char* arguments()
+	{
+		return s_arguments.c_str();
+	}
+
+	const char* current_dir()
+	{
+		return s_current_dir;
+	}
+
+	const char* home_dir()
+	{
+		#ifdef _WIN32
+			auto user_profile = getenv("USERPROFILE");
+			CHECK_F(user_profile != nullptr, "Missing USERPROFILE");
+			return user_profile;
+		#else // _WIN32
+			auto home = getenv("HOME");
+			CHECK_F(home != nullptr, "Missing HOME");
+			return home;
+		#endif // _WIN32
+	}
+
+	void suggest_log_path(const char* prefix, char* buff, unsigned buff_size)
+	{
+		if (prefix[0] == '~') {
+			snprintf(buff, buff_size - 1, "%s%s", home_dir(), prefix + 1);
+		} else {
+			snprintf(buff, buff_size - 1, "%s", prefix);
+		}
+
+		// Check for terminating /
+		size_t n = strlen(buff);
+		if (n != 0) {
+			if (buff[n - 1] != '/') {
+				CHECK_F(n + 2 < buff_size, "Filename buffer too small");
+				buff[n] = '/';
+				buff[n + 1] = '\0';
+			}
+		}
+
+		strncat(buff, s_argv0_filename.c_str(), buff_size - strlen(buff) - 1);
+		strncat(buff, "/",                      buff_size - strlen(buff) - 1);
+		write_date_time(buff + strlen(buff),    buff_size - strlen(buff));
+		strncat(buff, ".log",                   buff_size - strlen(buff) - 1);
+	}
+
+	bool create_directories(const char* file_path_const)
+	{
+		CHECK_F(file_path_const && *file_path_const);
+		char* file_path = strdup(file_path_const);
+		for (char* p = strchr(file_path + 1, '/'); p; p = strchr(p + 1, '/')) {
+			*p = '\0';
+
+	#ifdef _MSC_VER
+			if (_mkdir(file_path) == -1) {
+	#else
+			if (mkdir(file_path, 0755) == -1) {
+	#endif
+				if (errno != EEXIST) {
+					LOG_F(ERROR, "Failed to create directory '%s'", file_path);
+					LOG_IF_F(ERROR, errno == EACCES,       "EACCES");
+					LOG_IF_F(ERROR, errno == ENAMETOOLONG, "ENAMETOOLONG");
+					LOG_IF_F(ERROR, errno == ENOENT,       "ENOENT");
+					LOG_IF_F(ERROR, errno == ENOTDIR,      "ENOTDIR");
+					LOG_IF_F(ERROR, errno == ELOOP,        "ELOOP");
+
+					*p = '/';
+					free(file_path);
+					return false;
+				}
+			}
+			*p = '/';
+		}
+		free(file_path);
+		return true;
+	}
+	static std::string file_header(FileMode mode, Verbosity verbosity)
+	{
+		std::string header;
+		if (mode == FileMode::Append) {
+			header += "\n\n\n\n\n";
+		}
+		if (!s_arguments.empty()) {
+			header += textprintf("arguments: %s\n", s_arguments.c_str()).c_str();
+		}
+		if (strlen(s_current_dir) != 0) {
+			header += textprintf("Current dir: %s\n", s_current_dir).c_str();
+		}
+		header += textprintf("File verbosity level: %d\n", verbosity).c_str();
+		header += textprintf("%s\n", preamble_explain()).c_str();
+		return header;
+	}
+
+#ifndef _WIN32
+	static bool add_shared_file(const char* path_in, const char* path, Verbosity verbosity, unsigned index_interval)
+	{
+		const int fd = open(path, O_WRONLY | O_CREAT | O_APPEND | O_CLOEXEC, 0644);
+		if (fd == -1) {
+			LOG_F(ERROR, "Failed to open '%s'", path);
+			return false;
+		}
+		LOG_IF_F(WARNING, index_interval != 0, "No index for '%s': AppendShared files have none", path);
+
+		const std::string header = file_header(FileMode::AppendShared, verbosity);
+		shared_file_write(fd, header.data(), header.size());
+
+		auto file = new SharedFile(); // this is deleted in shared_file_close;
+		file->fd = fd;
+		add_line_callback(path_in, shared_file_log, file, verbosity, shared_file_close, shared_file_flush);
+
+		LOG_F(INFO, "Logging to '%s', mode: 'a' (shared), verbosity: %d", path, verbosity);
+		return true;
+	}
+#endif // !_WIN32
+
+	bool add_file(const char* path_in, FileMode mode, Verbosity verbosity, unsigned index_interval)
+	{
+		char path[PATH_MAX];
+		if (path_in[0] == '~') {
+			snprintf(path, sizeof(path) - 1, "%s%s", home_dir(), path_in + 1);
+		} else {
+			snprintf(path, sizeof(path) - 1, "%s", path_in);
+		}
+
+		if (!create_directories(path)) {
+			LOG_F(ERROR, "Failed to create directories to '%s'", path);
+		}
+
+#ifndef _WIN32
+		if (mode == FileMode::AppendShared) {
+			return add_shared_file(path_in, path, verbosity, index_interval);
+		}
+#endif
+
+		const char* mode_str = (mode == FileMode::Truncate ? "w" : "a");
+		auto file = fopen(path, mode_str);
+		if (!file) {
+			LOG_F(ERROR, "Failed to open '%s'", path);
+			return false;
+		}
+
+		FILE* index = nullptr;
+		if (index_interval != 0) {
+			const std::string index_path = std::string(path) + ".idx";
+			index = fopen(index_path.c_str(), mode == FileMode::Truncate ? "wb" : "ab");
+			if (!index) {
+				LOG_F(ERROR, "Failed to open '%s'", index_path.c_str());
+				fclose(file);
+				return false;
+			}
+			fseek(index, 0, SEEK_END);
+			if (ftell(index) == 0) {
+				fwrite(s_index_magic, 1, sizeof(s_index_magic), index);
+			}
+		}
+
+		// Write the header before the callback is added, so the index knows where the lines start.
+		const std::string header = file_header(mode, verbosity);
+		fwrite(header.data(), 1, header.size(), file);
+		fflush(file);
+
+#if LOGURU_WITH_FILEABS
+		FileAbs* file_abs = new FileAbs(); // this is deleted in file_close;
+		snprintf(file_abs->path, sizeof(file_abs->path) - 1, "%s", path);
+		snprintf(file_abs->mode_str, sizeof(file_abs->mode_str) - 1, "%s", mode_str);
+		stat(file_abs->path, &file_abs->st);
+		file_abs->fp = file;
+		file_abs->verbosity = verbosity;
+		void* user_data = file_abs;
+#else
+		void* user_data = file;
+#endif
+		if (index) {
+			auto indexed = new IndexedFile(); // this is deleted in indexed_file_close;
+			indexed->file     = user_data;
+			indexed->index    = index;
+			indexed->interval = index_interval;
+			indexed->offset   = ftell(file);
+			add_line_callback(path_in, indexed_file_log, indexed, verbosity, indexed_file_close, indexed_file_flush);
+		} else {
+			add_line_callback(path_in, file_log, user_data, verbosity, file_close, file_flush);
+		}
+
+		LOG_F(INFO, "Logging to '%s', mode: '%s', verbosity: %d", path, mode_str, verbosity);
+		return true;
+	}
+
+	bool add_socket(const char* path, SocketProtocol protocol, Verbosity verbosity)
+	{
+#ifdef _WIN32
+		(void)protocol;
+		(void)verbosity;
+		LOG_F(ERROR, "Failed to open socket '%s': no AF_UNIX sockets on this platform", path);
+		return false;
+#else
+		auto sink = new SocketSink(); // this is deleted in socket_close;
+		sink->path = path;
+		sink->protocol = protocol;
+		if (!socket_connect(sink)) {
+			const auto why = errno_as_text();
+			LOG_F(ERROR, "Failed to connect to socket '%s': %s", path, why.c_str());
+			delete sink;
+			return false;
+		}
+		add_line_callback(path, socket_log, sink, verbosity, socket_close, socket_flush);
+
+		LOG_F(INFO, "Logging to socket '%s', protocol: %s, type: %s, verbosity: %d", path,
+			  protocol == Journald ? "journald" : "plain", sink->is_stream ? "stream" : "datagram", verbosity);
+		return true;
+#endif
+	}
+
+	// Will be called right before abort().
+	void set_fatal_handler(fatal_handler_t handler)
+	{
+		s_fatal_handler = handler;
+	}
+
+	void add_stack_cleanup(const char* find_this, const char* replace_with_this)
+	{
+		if (strlen(find_this) <= strlen(replace_with_this)) {
+			LOG_F(WARNING, "add_stack_cleanup: the replacement should be shorter than the pattern!");
+			return;
+		}
+
+		s_user_stack_cleanups.push_back(StringPair(find_this, replace_with_this));
+	}
+
+	static void on_callback_change()
+	{
+		install_fork_handlers(); // Sinks may buffer.
+		Verbosity max_out_verbosity = Verbosity_OFF;
+		Verbosity max_raised_verbosity = Verbosity_OFF;
+		s_has_filters = false;
+		s_batch_tick_ms = 0;
+		bool has_thread_filters = false;
+		for (const auto& callback : s_callbacks) {
+			max_out_verbosity = std::max(max_out_verbosity, callback.verbosity);
+			max_raised_verbosity = std::max(max_raised_verbosity, callback.raised_verbosity);
+			s_has_filters |= !callback.filters.empty();
+			for (const auto& filter : callback.filters) {
+				has_thread_filters |= !filter.thread.empty();
+			}
+			if (callback.batch) {
+				// Check twice per latency, so no batch waits much longer than asked for.
+				// At least every 100 ms, so the flusher notices new callbacks with shorter latencies.
+				const unsigned tick = std::max(1u, std::min(callback.batch->max_latency_ms / 2, 100u));
+				s_batch_tick_ms = s_batch_tick_ms == 0 ? tick : std::min(s_batch_tick_ms, tick);
+			}
+		}
+		for (const auto& module : s_module_verbosities) {
+			max_out_verbosity = std::max(max_out_verbosity, module.verbosity);
+		}
+		s_max_out_verbosity = max_out_verbosity; // One store, so readers never see a partial maximum.
+		s_max_raised_verbosity = max_raised_verbosity;
+		bump_verbosity_generation();
+		s_callsite_routing.clear(); // Indices or verbosities may have changed.
+		s_has_thread_filters = has_thread_filters;
+	}
+
+	void add_callback(const char* id, log_handler_t callback, void* user_data,
+					  Verbosity verbosity, close_handler_t on_close, flush_handler_t on_flush)
+	{
+		std::lock_guard<LogMutex> lock(s_mutex);
+		s_callbacks.push_back(Callback{id, callback, user_data, verbosity, on_close, on_flush, nullptr, {}, nullptr, nullptr, Verbosity_OFF});
+		on_callback_change();
+	}
+
+	void add_batch_callback(const char* id, batch_handler_t callback, void* user_data, Verbosity verbosity,
+							unsigned max_batch_size, unsigned max_latency_ms,
+							close_handler_t on_close, flush_handler_t on_flush)
+	{
+		std::lock_guard<LogMutex> lock(s_mutex);
+		auto batch = std::make_shared<Batch>();
+		batch->max_size = std::max(max_batch_size, 1u);
+		batch->max_latency_ms = max_latency_ms;
+		batch->pending.entries.reserve(batch->max_size);
+		s_callbacks.push_back(Callback{id, nullptr, user_data, verbosity, on_close, on_flush, nullptr, {}, callback, batch, Verbosity_OFF});
+		on_callback_change();
+	}
+
+	static bool batch_due(const Batch& batch)
+	{
+		return !batch.pending.entries.empty() &&
+			(batch.pending.entries.size() >= batch.max_size ||
+			 steady_clock::now() - batch.first_time >= milliseconds(batch.max_latency_ms));
+	}
+
+	// Called with s_mutex held. The callback may log, even to itself.
+	static void deliver_batch(const Callback& p)
+	{
+		const auto batch = p.batch; // p may move if the callback adds or removes callbacks.
+		const auto callback = p.batch_callback;
+		const auto on_flush = p.flush;
+		const auto user_data = p.user_data;
+		if (batch->pending.entries.empty()) { return; }
+
+		MessageStore store;
+		std::swap(store, batch->pending);
+
+		std::vector<Message> messages;
+		messages.reserve(store.entries.size());
+		for (size_t i = 0; i < store.entries.size(); ++i) {
+			messages.push_back(store.get(i));
+		}
+		callback(user_data, messages.data(), static_cast<unsigned>(messages.size()));
+		if (on_flush) { on_flush(user_data); }
+
+		if (batch->pending.entries.empty()) {
+			// Hand the memory back for the next batch:
+			store.clear();
+			std::swap(store, batch->pending);
+		}
+	}
+
+	static void append_to_batch(const Callback& p, const Message& message)
+	{
+		auto& batch = *p.batch;
+		if (batch.pending.entries.empty()) {
+			batch.first_time = steady_clock::now();
+		}
+		batch.pending.add(message);
+		if (batch_due(batch)) {
+			deliver_batch(p);
+		}
+	}
+
+	static void add_line_callback(const char* id, line_handler_t line_callback, void* user_data,
+								  Verbosity verbosity, close_handler_t on_close, flush_handler_t on_flush)
+	{
+		std::lock_guard<LogMutex> lock(s_mutex);
+		s_callbacks.push_back(Callback{id, nullptr, user_data, verbosity, on_close, on_flush, line_callback, {}, nullptr, nullptr, Verbosity_OFF});
+		on_callback_change();
+	}
+
+	bool remove_callback(const char* id)
+	{
+		std::lock_guard<LogMutex> lock(s_mutex);
+		auto it = std::find_if(begin(s_callbacks), end(s_callbacks), [&](const Callback& c) { return c.id == id; });
+		if (it != s_callbacks.end()) {
+			if (it->batch) {
+				deliver_batch(*it);
+				it = std::find_if(begin(s_callbacks), end(s_callbacks), [&](const Callback& c) { return c.id == id; });
+				if (it == s_callbacks.end()) { return true; } // The callback removed itself.
+			}
+			if (it->close) { it->close(it->user_data); }
+			s_callbacks.erase(it);
+			on_callback_change();
+			return true;
+		} else {
+			LOG_F(ERROR, "Failed to locate callback with id '%s'", id);
+			return false;
+		}
+	}
+
+	static Callback* find_callback(const char* id)
+	{
+		auto it = std::find_if(begin(s_callbacks), end(s_callbacks), [&](const Callback& c) { return c.id == id; });
+		return it == s_callbacks.end() ? nullptr : &*it;
+	}
+
+	bool add_filter(const char* id, const FilterRule& rule)
+	{
+		std::lock_guard<LogMutex> lock(s_mutex);
+		Callback* callback = find_callback(id);
+		if (!callback) {
+			LOG_F(ERROR, "Failed to locate callback with id '%s'", id);
+			return false;
+		}
+		CompiledFilter filter;
+		filter.file = rule.file ? rule.file : "";
+		filter.thread = rule.thread ? rule.thread : "";
+		filter.has_message = rule.message != nullptr;
+		if (rule.message) {
+			try {
+				filter.message = std::regex(rule.message, std::regex::ECMAScript | std::regex::optimize);
+			} catch (std::regex_error& e) {
+				LOG_F(ERROR, "Bad filter regex '%s': %s", rule.message, e.what());
+				return false;
+			}
+		}
+		callback->filters.push_back(std::move(filter));
+		on_callback_change();
+		return true;
+	}
+
+	bool clear_filters(const char* id)
+	{
+		std::lock_guard<LogMutex> lock(s_mutex);
+		Callback* callback = find_callback(id);
+		if (!callback) {
+			LOG_F(ERROR, "Failed to locate callback with id '%s'", id);
+			return false;
+		}
+		callback->filters.clear();
+		on_callback_change();
+		return true;
+	}
+
+	bool set_callback_verbosity(const char* id, Verbosity verbosity)
+	{
+		std::lock_guard<LogMutex> lock(s_mutex);
+		Callback* callback = find_callback(id);
+		if (!callback) {
+			LOG_F(ERROR, "Failed to locate callback with id '%s'", id);
+			return false;
+		}
+		callback->verbosity = verbosity;
+		on_callback_change();
+		return true;
+	}
+
+	bool set_callback_raised_verbosity(const char* id, Verbosity verbosity)
+	{
+		std::lock_guard<LogMutex> lock(s_mutex);
+		Callback* callback = find_callback(id);
+		if (!callback) {
+			LOG_F(ERROR, "Failed to locate callback with id '%s'", id);
+			return false;
+		}
+		callback->raised_verbosity = verbosity;
+		on_callback_change();
+		return true;
+	}
+
+	void set_module_verbosity(const char* file_glob, Verbosity verbosity)
+	{
+		std::lock_guard<LogMutex> lock(s_mutex);
+		for (auto& module : s_module_verbosities) {
+			if (module.file_glob == file_glob) {
+				module.verbosity = verbosity;
+				on_callback_change();
+				return;
+			}
+		}
+		s_module_verbosities.push_back(ModuleVerbosity{file_glob, verbosity});
+		on_callback_change();
+	}
+
+	void clear_module_verbosities()
+	{
+		std::lock_guard<LogMutex> lock(s_mutex);
+		s_module_verbosities.clear();
+		on_callback_change();
+	}
+
+	static void trim(std::string& str)
+	{
+		const char* whitespace = " \t\r\n";
+		str.erase(0, std::min(str.find_first_not_of(whitespace), str.size()));
+		str.erase(str.find_last_not_of(whitespace) + 1);
+	}
+
+	bool load_verbosity_config(const char* path)
+	{
+		FILE* file = fopen(path, "r");
+		if (!file) {
+			const auto why = errno_as_text();
+			LOG_F(ERROR, "Failed to open verbosity config '%s': %s", path, why.c_str());
+			return false;
+		}
+
+		// Parse everything first, so we either apply all of it or nothing.
+		bool has_stderr = false;
+		Verbosity new_stderr_verbosity = stderr_verbosity();
+		std::vector<std::pair<std::string, Verbosity>> sinks;
+		std::vector<ModuleVerbosity> modules;
+		bool ok = true;
+
+		char line_buff[1024];
+		for (unsigned line_nr = 1; fgets(line_buff, sizeof(line_buff), file); ++line_nr) {
+			std::string line = line_buff;
+			line.erase(std::min(line.find('#'), line.size()));
+			trim(line);
+			if (line.empty()) { continue; }
+
+			const auto equals = line.rfind('=');
+			if (equals == std::string::npos) {
+				LOG_F(ERROR, "%s:%u: expected 'key = verbosity'", path, line_nr);
+				ok = false;
+				continue;
+			}
+			std::string key = line.substr(0, equals);
+			std::string value = line.substr(equals + 1);
+			trim(key);
+			trim(value);
+
+			Verbosity verbosity;
+			if (!parse_verbosity(value.c_str(), &verbosity)) {
+				LOG_F(ERROR, "%s:%u: invalid verbosity '%s'", path, line_nr, value.c_str());
+				ok = false;
+				continue;
+			}
+
+			if (key == "stderr") {
+				has_stderr = true;
+				new_stderr_verbosity = verbosity;
+			} else if (key.compare(0, 5, "sink ") == 0) {
+				std::string id = key.substr(5);
+				trim(id);
+				sinks.emplace_back(id, verbosity);
+			} else if (key.compare(0, 7, "module ") == 0) {
+				std::string glob = key.substr(7);
+				trim(glob);
+				modules.push_back(ModuleVerbosity{glob, verbosity});
+			} else {
+				LOG_F(ERROR, "%s:%u: unknown key '%s'", path, line_nr, key.c_str());
+				ok = false;
+			}
+		}
+		fclose(file);
+
+		std::lock_guard<LogMutex> lock(s_mutex);
+		for (const auto& sink : sinks) {
+			if (!find_callback(sink.first.c_str())) {
+				LOG_F(ERROR, "%s: no sink with id '%s'", path, sink.first.c_str());
+				ok = false;
+			}
+		}
+		if (!ok) {
+			LOG_F(ERROR, "Ignoring verbosity config '%s' due to errors", path);
+			return false;
+		}
+
+		if (has_stderr) {
+			set_stderr_verbosity(new_stderr_verbosity);
+		}
+		for (const auto& sink : sinks) {
+			find_callback(sink.first.c_str())->verbosity = sink.second;
+		}
+		s_module_verbosities = modules;
+		on_callback_change();
+
+		LOG_F(INFO, "Loaded verbosity config '%s': stderr verbosity: %d, %u sink(s), %u module(s)", path,
+			  stderr_verbosity(), static_cast<unsigned>(sinks.size()), static_cast<unsigned>(modules.size()));
+		return true;
+	}
+
+#ifndef _WIN32
+	static void on_reload_signal(int)
+	{
+		s_config_reload_requested = true;
+	}
+#endif // _WIN32
+
+	static void start_config_watcher();
+
+	void watch_verbosity_config(const char* path_in, unsigned poll_interval_ms, bool reload_on_sighup)
+	{
+		std::lock_guard<LogMutex> lock(s_mutex);
+		if (s_config_thread) {
+			LOG_F(ERROR, "watch_verbosity_config: already watching a config file");
+			return;
+		}
+
+#ifndef _WIN32
+		if (reload_on_sighup) {
+			struct sigaction sig_action;
+			memset(&sig_action, 0, sizeof(sig_action));
+			sigemptyset(&sig_action.sa_mask);
+			sig_action.sa_handler = &on_reload_signal;
+			sig_action.sa_flags = SA_RESTART;
+			CHECK_F(sigaction(SIGHUP, &sig_action, &s_config_old_sighup) != -1, "Failed to install handler for SIGHUP");
+			s_config_sighup = true;
+		}
+#else
+		(void)reload_on_sighup;
+#endif // _WIN32
+
+		install_fork_handlers();
+		s_config_path = path_in;
+		s_config_poll_interval_ms = std::max(poll_interval_ms, 1u); // 0 would spin.
+		start_config_watcher();
+	}
+
+	void unwatch_verbosity_config()
+	{
+		std::thread* thread = nullptr;
+		{
+			std::lock_guard<LogMutex> lock(s_mutex);
+			if (!s_config_thread && !s_config_restart_needed) {
+				return;
+			}
+			thread = s_config_thread;
+			s_config_thread = nullptr;
+			s_config_restart_needed = false;
+			s_config_stop = true;
+#ifndef _WIN32
+			if (s_config_sighup) {
+				sigaction(SIGHUP, &s_config_old_sighup, NULL);
+				s_config_sighup = false;
+			}
+#endif // _WIN32
+		}
+		if (thread) {
+			// Outside of s_mutex, which the watcher takes when it reloads:
+			thread->join();
+			delete thread;
+		}
+	}
+
+	// Called with s_mutex held.
+	static void start_config_watcher()
+	{
+		const std::string path = s_config_path;
+		const unsigned poll_interval_ms = s_config_poll_interval_ms;
+		s_config_restart_needed = false;
+		s_config_stop = false;
+		s_config_thread = new std::thread([path, poll_interval_ms](){
+			struct stat last_st;
+			memset(&last_st, 0, sizeof(last_st));
+			bool has_file = (stat(path.c_str(), &last_st) == 0);
+			if (has_file) {
+				load_verbosity_config(path.c_str());
+			}
+			const auto tick = std::chrono::milliseconds(std::min(poll_interval_ms, 100u));
+			auto waited = std::chrono::milliseconds(0);
+			while (!s_config_stop) {
+				std::this_thread::sleep_for(tick);
+				waited += tick;
+				if (s_config_stop) { break; }
+				bool reload = s_config_reload_requested.exchange(false);
+				if (waited.count() >= poll_interval_ms) {
+					waited = std::chrono::milliseconds(0);
+					struct stat st;
+					if (stat(path.c_str(), &st) == 0) {
+						reload |= !has_file || st.st_mtime != last_st.st_mtime ||
+								  st.st_size != last_st.st_size || st.st_ino != last_st.st_ino;
+						last_st = st;
+						has_file = true;
+					} else {
+						has_file = false;
+					}
+				}
+				if (reload) {
+					load_verbosity_config(path.c_str());
+				}
+			}
+		});
+	}
+
+	void remove_all_callbacks()
+	{
+		std::lock_guard<LogMutex> lock(s_mutex);
+		for (size_t i = 0; i < s_callbacks.size(); ++i) {
+			if (s_callbacks[i].batch) { deliver_batch(s_callbacks[i]); }
+		}
+		for (auto& callback : s_callbacks) {
+			if (callback.close) {
+				callback.close(callback.user_data);
+			}
+		}
+		s_callbacks.clear();
+		on_callback_change();
+	}
+
+	// Set by ScopedVerbosity.
+	static thread_local Verbosity s_thread_verbosity = Verbosity_OFF;
+
+	// Only the cutoff of this thread changes, so there is no need to bump g_verbosity_generation for all of them.
+	ScopedVerbosity::ScopedVerbosity(Verbosity verbosity) : _previous(s_thread_verbosity)
+	{
+		s_thread_verbosity = std::max(_previous, verbosity);
+		g_verbosity_cutoff_cache.generation = 0;
+	}
+
+	ScopedVerbosity::~ScopedVerbosity()
+	{
+		s_thread_verbosity = _previous;
+		g_verbosity_cutoff_cache.generation = 0;
+	}
+
+	Verbosity thread_verbosity()
+	{
+		return s_thread_verbosity;
+	}
+
+	Verbosity refresh_verbosity_cutoff()
+	{
+		// Generation first: a change made after this read bumps it again, so we never keep a stale cutoff.
+	#if defined(__GNUC__) || defined(__clang__)
+		const unsigned generation = __atomic_load_n(&g_verbosity_generation, __ATOMIC_ACQUIRE);
+	#else
+		const unsigned generation = *static_cast<volatile unsigned*>(&g_verbosity_generation);
+	#endif
+		const Verbosity stderr_cutoff = stderr_verbosity();
+		const Verbosity max_out_verbosity = s_max_out_verbosity.load(std::memory_order_relaxed);
+		Verbosity cutoff = stderr_cutoff > max_out_verbosity ? stderr_cutoff : max_out_verbosity;
+		if (s_thread_verbosity > cutoff) {
+			// Nobody wants more than this of a raised thread, so do not bother formatting it:
+			const Verbosity raised = std::min(s_thread_verbosity, s_max_raised_verbosity.load(std::memory_order_relaxed));
+			cutoff = raised > cutoff ? raised : cutoff;
+		}
+		g_verbosity_cutoff_cache.generation = generation;
+		g_verbosity_cutoff_cache.stderr_verbosity = stderr_cutoff;
+		g_verbosity_cutoff_cache.cutoff = cutoff;
+		return cutoff;
+	}
+
+#if LOGURU_WINTHREADS
+	char* get_thread_name_win32()
+	{
+		__declspec( thread ) static char thread_name[LOGURU_THREADNAME_WIDTH + 1] = {0};
+		return &thread_name[0];
+	}
+#endif // LOGURU_WINTHREADS
+
+	void set_thread_name(const char* name)
+	{
+		#if LOGURU_PTLS_NAMES
+			(void)pthread_once(&s_pthread_key_once, make_pthread_key_name);
+			free(pthread_getspecific(s_pthread_key_name));
+			(void)pthread_setspecific(s_pthread_key_name, strdup(name));
+
+		#elif LOGURU_PTHREADS
+			#ifdef __APPLE__
+				pthread_setname_np(name);
+			#else
+				pthread_setname_np(pthread_self(), name);
+			#endif
+		#elif LOGURU_WINTHREADS
+			strncpy_s(get_thread_name_win32(), LOGURU_THREADNAME_WIDTH + 1, name, _TRUNCATE);
+		#else // LOGURU_PTHREADS
+			(void)name;
+		#endif // LOGURU_PTHREADS
+	}
+
+#if LOGURU_PTLS_NAMES
+	const char* get_thread_name_ptls()
+	{
+		(void)pthread_once(&s_pthread_key_once, make_pthread_key_name);
+		return static_cast<const char*>(pthread_getspecific(s_pthread_key_name));
+	}
+#endif // LOGURU_PTLS_NAMES
+
+	// Set by LOG_THREAD_ALIAS. Empty if none.
+	static char* thread_alias()
+	{
+		static thread_local char s_alias[LOGURU_THREADNAME_WIDTH + 1] = {0};
+		return s_alias;
+	}
+
+	ThreadAliasScope::ThreadAliasScope(const char* name)
+	{
+		char* alias = thread_alias();
+		memcpy(_previous, alias, sizeof(_previous));
+		snprintf(alias, LOGURU_THREADNAME_WIDTH + 1, "%s", name);
+	}
+
+	ThreadAliasScope::~ThreadAliasScope()
+	{
+		memcpy(thread_alias(), _previous, sizeof(_previous));
+	}
+
+	void get_thread_name(char* buffer, unsigned long long length, bool right_align_hext_id)
+	{
+		CHECK_NE_F(length, 0u, "Zero length buffer in get_thread_name");
+		CHECK_NOTNULL_F(buffer, "nullptr in get_thread_name");
+		const char* alias = thread_alias();
+		if (alias[0] != 0) {
+			snprintf(buffer, (size_t)length, "%s", alias);
+			return;
+		}
+#if LOGURU_PTHREADS
+		auto thread = pthread_self();
+		#if LOGURU_PTLS_NAMES
+			if (const char* name = get_thread_name_ptls()) {
+				snprintf(buffer, length, "%s", name);
+			} else {
+				buffer[0] = 0;
+			}
+		#else
+			pthread_getname_np(thread, buffer, length);
+		#endif
+
+		if (buffer[0] == 0) {
+			#ifdef __APPLE__
+				uint64_t thread_id;
+				pthread_threadid_np(thread, &thread_id);
+			#else
+				uint64_t thread_id = thread;
+			#endif
+			if (right_align_hext_id) {
+				snprintf(buffer, length, "%*X", static_cast<int>(length - 1), static_cast<unsigned>(thread_id));
+			} else {
+				snprintf(buffer, length, "%X", static_cast<unsigned>(thread_id));
+			}
+		}
+#elif LOGURU_WINTHREADS
+		if (const char* name = get_thread_name_win32()) {
+			snprintf(buffer, (size_t)length, "%s", name);
+		} else {
+			buffer[0] = 0;
+		}
+#else // !LOGURU_WINTHREADS && !LOGURU_WINTHREADS
+		buffer[0] = 0;
+#endif
+
+	}
+
+	// ------------------------------------------------------------------------
+	// Stack traces
+
+#if LOGURU_STACKTRACES
+	Text demangle(const char* name)
+	{
+		int status = -1;
+		char* demangled = abi::__cxa_demangle(name, 0, 0, &status);
+		Text result{status == 0 ? demangled : strdup(name)};
+		return result;
+	}
+
+	template <class T>
+	std::string type_name() {
+		auto demangled = demangle(typeid(T).name());
+		return demangled.c_str();
+	}
+
+	static const StringPairList REPLACE_LIST = {
+		{ type_name<std::string>(),    "std::string"    },
+		{ type_name<std::wstring>(),   "std::wstring"   },
+		{ type_name<std::u16string>(), "std::u16string" },
+		{ type_name<std::u32string>(), "std::u32string" },
+		{ "std::__1::",                "std::"          },
+		{ "__thiscall ",               ""               },
+		{ "__cdecl ",                  ""               },
+	};
+
+	void do_replacements(const StringPairList& replacements, std::string& str)
+	{
+		for (auto&& p : replacements) {
+			if (p.first.size() <= p.second.size()) {
+				// On gcc, "type_name<std::string>()" is "std::string"
+				continue;
+			}
+
+			size_t it;
+			while ((it=str.find(p.first)) != std::string::npos) {
+				str.replace(it, p.first.size(), p.second);
+			}
+		}
+	}
+
+	std::string prettify_stacktrace(const std::string& input)
+	{
+		std::string output = input;
+
+		do_replacements(s_user_stack_cleanups, output);
+		do_replacements(REPLACE_LIST, output);
+
+		try {
+			std::regex std_allocator_re(R"(,\s*std::allocator<[^<>]+>)");
+			output = std::regex_replace(output, std_allocator_re, std::string(""));
+
+			std::regex template_spaces_re(R"(<\s*([^<> ]+)\s*>)");
+			output = std::regex_replace(output, template_spaces_re, std::string("<$1>"));
+		} catch (std::regex_error&) {
+			// Probably old GCC.
+		}
+
+		return output;
+	}
+
+	std::string stacktrace_as_stdstring(int skip)
+	{
+		// From https://gist.github.com/fmela/591333
+		void* callstack[128];
+		const auto max_frames = sizeof(callstack) / sizeof(callstack[0]);
+		int num_frames = backtrace(callstack, max_frames);
+		char** symbols = backtrace_symbols(callstack, num_frames);
+
+		std::string result;
+		// Print stack traces so the most relevant ones are written last
+		// Rationale: http://yellerapp.com/posts/2015-01-22-upside-down-stacktraces.html
+		for (int i = num_frames - 1; i >= skip; --i) {
+			char buf[1024];
+			Dl_info info;
+			if (dladdr(callstack[i], &info) && info.dli_sname) {
+				char* demangled = NULL;
+				int status = -1;
+				if (info.dli_sname[0] == '_') {
+					demangled = abi::__cxa_demangle(info.dli_sname, 0, 0, &status);
+				}
+				snprintf(buf, sizeof(buf), "%-3d %*p %s + %zd\n",
+						 i - skip, int(2 + sizeof(void*) * 2), callstack[i],
+						 status == 0 ? demangled :
+						 info.dli_sname == 0 ? symbols[i] : info.dli_sname,
+						 static_cast<char*>(callstack[i]) - static_cast<char*>(info.dli_saddr));
+				free(demangled);
+			} else {
+				snprintf(buf, sizeof(buf), "%-3d %*p %s\n",
+						 i - skip, int(2 + sizeof(void*) * 2), callstack[i], symbols[i]);
+			}
+			result += buf;
+		}
+		free(symbols);
+
+		if (num_frames == max_frames) {
+			result = "[truncated]\n" + result;
+		}
+
+		if (!result.empty() && result[result.size() - 1] == '\n') {
+			result.resize(result.size() - 1);
+		}
+
+		return prettify_stacktrace(result);
+	}
+
+#else // LOGURU_STACKTRACES
+	Text demangle(const char* name)
+	{
+		return Text::copy(name);
+	}
+
+	std::string stacktrace_as_stdstring(int)
+	{
+		#if defined(_MSC_VER)
+		#pragma message ( "Loguru: No stacktraces available on this platform" )
+		#else
+		#warning "Loguru: No stacktraces available on this platform"
+		#endif
+		return "";
+	}
+
+#endif // LOGURU_STACKTRACES
+
+	Text stacktrace(int skip)
+	{
+		auto str = stacktrace_as_stdstring(skip + 1);
+		return Text::copy(str.c_str());
+	}
+
+	// ------------------------------------------------------------------------
+
+	// Bounded writer used by print_preamble.
+	struct PreambleWriter
+	{
+		char* ptr;
+		char* end;
+
+		void put(char c)
+		{
+			if (ptr < end) { *ptr++ = c; }
+		}
+
+		void put(const char* str, size_t length)
+		{
+			length = std::min(length, static_cast<size_t>(end - ptr));
+			memcpy(ptr, str, length);
+			ptr += length;
+		}
+
+		void pad(char c, int count)
+		{
+			for (; count > 0; --count) { put(c); }
+		}
+
+		// Zero-padded to at least min_digits.
+		void put_uint(unsigned long long value, int min_digits)
+		{
+			char digits[24];
+			int num_digits = 0;
+			do {
+				digits[num_digits++] = static_cast<char>('0' + value % 10);
+				value /= 10;
+			} while (value != 0);
+			pad('0', min_digits - num_digits);
+			while (num_digits > 0) { put(digits[--num_digits]); }
+		}
+
+		void put_aligned(const char* str, int width, bool left_align)
+		{
+			const auto length = strlen(str);
+			if (!left_align) { pad(' ', width - static_cast<int>(length)); }
+			put(str, length);
+			if (left_align) { pad(' ', width - static_cast<int>(length)); }
+		}
+	};
+
+	static bool preamble_needs_uptime()
+	{
+		return preamble_program().needs_uptime;
+	}
+
+	static void print_preamble(char* out_buff, size_t out_buff_size, const Timestamp& timestamp,
+							   Verbosity verbosity, const char* file, unsigned line)
+	{
+		if (out_buff_size == 0) { return; }
+		const PreambleProgram& program = preamble_program();
+
+		const long long ms_since_epoch = timestamp.epoch_ns / 1000000;
+		tm time_info = tm();
+		if (program.needs_local_time) {
+			local_time(time_t(ms_since_epoch / 1000), &time_info);
+		}
+
+		const long long uptime_ms = timestamp.uptime_ns / 1000000;
+
+		PreambleWriter out{out_buff, out_buff + out_buff_size - 1};
+
+		for (const auto& op : program.ops) {
+			switch (op.field) {
+			case PreambleField::Literal:
+				out.put(op.literal.data(), op.literal.size());
+				break;
+			case PreambleField::Date:
+				out.put_uint(static_cast<unsigned>(1900 + time_info.tm_year), 4);
+				out.put('-');
+				out.put_uint(static_cast<unsigned>(1 + time_info.tm_mon), 2);
+				out.put('-');
+				out.put_uint(static_cast<unsigned>(time_info.tm_mday), 2);
+				break;
+			case PreambleField::Time:
+				out.put_uint(static_cast<unsigned>(time_info.tm_hour), 2);
+				out.put(':');
+				out.put_uint(static_cast<unsigned>(time_info.tm_min), 2);
+				out.put(':');
+				out.put_uint(static_cast<unsigned>(time_info.tm_sec), 2);
+				break;
+			case PreambleField::Millis:
+				out.put_uint(static_cast<unsigned>(ms_since_epoch % 1000), 3);
+				break;
+			case PreambleField::EpochNs:
+				out.put_uint(static_cast<unsigned long long>(timestamp.epoch_ns), 1);
+				break;
+			case PreambleField::Uptime: {
+				// Same as "%8.3f" of the uptime in seconds.
+				char uptime_buff[32];
+				PreambleWriter uptime{uptime_buff, uptime_buff + sizeof(uptime_buff) - 1};
+				uptime.put_uint(static_cast<unsigned long long>(uptime_ms / 1000), 1);
+				uptime.put('.');
+				uptime.put_uint(static_cast<unsigned long long>(uptime_ms % 1000), 3);
+				*uptime.ptr = '\0';
+				out.put_aligned(uptime_buff, 8, false);
+				break;
+			}
+			case PreambleField::Thread: {
+				char thread_name[LOGURU_THREADNAME_WIDTH + 1] = {0};
+				get_thread_name(thread_name, LOGURU_THREADNAME_WIDTH + 1, true);
+				out.put_aligned(thread_name, LOGURU_THREADNAME_WIDTH, true);
+				break;
+			}
+			case PreambleField::File:
+			#if LOGURU_USE_FILE_NAME
+				out.put_aligned(file, LOGURU_FILENAME_WIDTH, false); // The macros already passed just the file name.
+			#else
+				out.put_aligned(s_strip_file_path ? filename(file) : file, LOGURU_FILENAME_WIDTH, false);
+			#endif
+				break;
+			case PreambleField::Line: {
+				char line_buff[16];
+				PreambleWriter line_out{line_buff, line_buff + sizeof(line_buff) - 1};
+				line_out.put_uint(line, 1);
+				*line_out.ptr = '\0';
+				out.put_aligned(line_buff, 5, true);
+				break;
+			}
+			case PreambleField::Verbosity:
+				if (verbosity <= Verbosity_FATAL) {
+					out.put_aligned("FATL", 4, false);
+				} else if (verbosity == Verbosity_ERROR) {
+					out.put_aligned("ERR", 4, false);
+				} else if (verbosity == Verbosity_WARNING) {
+					out.put_aligned("WARN", 4, false);
+				} else {
+					char level_buff[16];
+					snprintf(level_buff, sizeof(level_buff), "%d", verbosity);
+					out.put_aligned(level_buff, 4, false);
+				}
+				break;
+			}
+		}
+		*out.ptr = '\0';
+	}
+
+	bool set_preamble_pattern(const char* pattern)
+	{
+		auto program = new PreambleProgram();
+		if (!compile_preamble(pattern, program)) {
+			delete program;
+			LOG_F(ERROR, "Bad preamble pattern: '%s'", pattern);
+			return false;
+		}
+		s_preamble_program.store(program, std::memory_order_release);
+		return true;
+	}
+
+	// Local time to seconds since epoch, with the last hour cached since mktime is slow.
+	static long long epoch_from_local(int year, int month, int day, int hour, int minute, int second)
+	{
+		static thread_local int       s_cached_hour[4] = {-1, -1, -1, -1};
+		static thread_local long long s_cached_epoch   = 0;
+		if (s_cached_hour[0] != year || s_cached_hour[1] != month ||
+		    s_cached_hour[2] != day  || s_cached_hour[3] != hour) {
+			tm time_info = tm();
+			time_info.tm_year  = year - 1900;
+			time_info.tm_mon   = month - 1;
+			time_info.tm_mday  = day;
+			time_info.tm_hour  = hour;
+			time_info.tm_isdst = -1;
+			s_cached_epoch = static_cast<long long>(mktime(&time_info));
+			s_cached_hour[0] = year;
+			s_cached_hour[1] = month;
+			s_cached_hour[2] = day;
+			s_cached_hour[3] = hour;
+		}
+		return s_cached_epoch + minute * 60 + second;
+	}
+
+	bool parse_log_line(const char* line, unsigned length, LogLine* out_line)
+	{
+		const PreambleProgram& program = preamble_program();
+		const char* ptr = line;
+		const char* end = line + length;
+
+		// Reads exactly num_digits digits.
+		const auto read_digits = [&](int num_digits, long long* out_value) {
+			long long value = 0;
+			for (int i = 0; i < num_digits; ++i, ++ptr) {
+				if (ptr == end || !isdigit(static_cast<unsigned char>(*ptr))) { return false; }
+				value = 10 * value + (*ptr - '0');
+			}
+			*out_value = value;
+			return true;
+		};
+		// Reads up to the next literal (or space, if there is none) and strips the padding.
+		const auto read_field = [&](size_t op_index, const char** out_begin, const char** out_end) {
+			while (ptr < end && *ptr == ' ') { ++ptr; }
+			const char delimiter = (op_index + 1 < program.ops.size() && program.ops[op_index + 1].field == PreambleField::Literal)
+				? program.ops[op_index + 1].literal[0] : ' ';
+			const char* field_end = static_cast<const char*>(memchr(ptr, delimiter, static_cast<size_t>(end - ptr)));
+			if (!field_end) {
+				if (delimiter != ' ') { return false; }
+				field_end = end;
+			}
+			*out_begin = ptr;
+			*out_end = field_end;
+			while (*out_end > *out_begin && (*out_end)[-1] == ' ') { --*out_end; }
+			ptr = field_end;
+			return true;
+		};
+
+		LogLine result = LogLine();
+		result.verbosity = Verbosity_INFO;
+		long long year = 0, month = 0, day = 0, hour = 0, minute = 0, second = 0, millis = 0;
+		bool has_date = false, has_epoch_ns = false;
+
+		for (size_t i = 0; i < program.ops.size(); ++i) {
+			const PreambleOp& op = program.ops[i];
+			const char* begin = nullptr;
+			const char* field_end = nullptr;
+			switch (op.field) {
+			case PreambleField::Literal:
+				if (static_cast<size_t>(end - ptr) < op.literal.size() ||
+				    memcmp(ptr, op.literal.data(), op.literal.size()) != 0) {
+					return false;
+				}
+				ptr += op.literal.size();
+				break;
+			case PreambleField::Date:
+				has_date = true;
+				if (!read_digits(4, &year) || ptr == end || *ptr++ != '-' ||
+				    !read_digits(2, &month) || ptr == end || *ptr++ != '-' || !read_digits(2, &day)) {
+					return false;
+				}
+				break;
+			case PreambleField::Time:
+				if (!read_digits(2, &hour) || ptr == end || *ptr++ != ':' ||
+				    !read_digits(2, &minute) || ptr == end || *ptr++ != ':' || !read_digits(2, &second)) {
+					return false;
+				}
+				break;
+			case PreambleField::Millis:
+				if (!read_digits(3, &millis)) { return false; }
+				break;
+			case PreambleField::EpochNs:
+			case PreambleField::Uptime:
+			case PreambleField::Line: {
+				if (!read_field(i, &begin, &field_end) || begin == field_end) { return false; }
+				long long value = 0;
+				long long fraction = 0;
+				for (const char* c = begin; c < field_end; ++c) {
+					if (*c == '.' && op.field == PreambleField::Uptime) {
+						fraction = 1;
+					} else if (isdigit(static_cast<unsigned char>(*c))) {
+						value = 10 * value + (*c - '0');
+						fraction *= 10;
+					} else {
+						return false;
+					}
+				}
+				if (op.field == PreambleField::EpochNs) {
+					result.timestamp_ns = value;
+					has_epoch_ns = true;
+				} else if (op.field == PreambleField::Uptime) {
+					result.uptime_ms = fraction == 0 ? value * 1000 : value * 1000 / fraction;
+				} else {
+					result.line = static_cast<unsigned>(value);
+				}
+				break;
+			}
+			case PreambleField::Thread:
+				if (!read_field(i, &begin, &field_end)) { return false; }
+				result.thread = begin;
+				result.thread_length = static_cast<unsigned>(field_end - begin);
+				break;
+			case PreambleField::File:
+				if (!read_field(i, &begin, &field_end)) { return false; }
+				result.file = begin;
+				result.file_length = static_cast<unsigned>(field_end - begin);
+				break;
+			case PreambleField::Verbosity: {
+				if (!read_field(i, &begin, &field_end) || begin == field_end) { return false; }
+				const size_t name_length = static_cast<size_t>(field_end - begin);
+				if (name_length == 4 && memcmp(begin, "FATL", 4) == 0) {
+					result.verbosity = Verbosity_FATAL;
+				} else if (name_length == 3 && memcmp(begin, "ERR", 3) == 0) {
+					result.verbosity = Verbosity_ERROR;
+				} else if (name_length == 4 && memcmp(begin, "WARN", 4) == 0) {
+					result.verbosity = Verbosity_WARNING;
+				} else {
+					const bool negative = (*begin == '-');
+					int value = 0;
+					for (const char* c = begin + negative; c < field_end; ++c) {
+						if (!isdigit(static_cast<unsigned char>(*c))) { return false; }
+						value = 10 * value + (*c - '0');
+					}
+					result.verbosity = static_cast<Verbosity>(negative ? -value : value);
+				}
+				break;
+			}
+			}
+		}
+
+		if (!has_epoch_ns && has_date) {
+			const long long seconds = epoch_from_local(static_cast<int>(year), static_cast<int>(month), static_cast<int>(day),
+			                                           static_cast<int>(hour), static_cast<int>(minute), static_cast<int>(second));
+			result.timestamp_ns = (seconds * 1000 + millis) * 1000 * 1000;
+		}
+		result.message = ptr;
+		result.message_length = static_cast<unsigned>(end - ptr);
+		*out_line = result;
+		return true;
+	}
+
+	// ------------------------------------------------------------------------
+	// Filters:
+
+	// Glob with * and ?.
+	static bool glob_match(const char* pattern, const char* str)
+	{
+		const char* star_pattern = nullptr;
+		const char* star_str = nullptr;
+		while (*str) {
+			if (*pattern == '*') {
+				star_pattern = ++pattern;
+				star_str = str;
+			} else if (*pattern == '?' || *pattern == *str) {
+				++pattern;
+				++str;
+			} else if (star_pattern) {
+				pattern = star_pattern;
+				str = ++star_str;
+			} else {
+				return false;
+			}
+		}
+		while (*pattern == '*') { ++pattern; }
+		return *pattern == '\0';
+	}
+
+	// Match against the whole path, or any tail of it starting at a path component.
+	static bool file_glob_match(const char* pattern, const char* path)
+	{
+		if (glob_match(pattern, path)) { return true; }
+		for (const char* ptr = path; *ptr; ++ptr) {
+			if ((*ptr == '/' || *ptr == '\\') && glob_match(pattern, ptr + 1)) {
+				return true;
+			}
+		}
+		return false;
+	}
+
+	static bool filter_accepts_dynamic(const CompiledFilter& filter, const Message& message)
+	{
+		if (!filter.thread.empty()) {
+			char thread_name[LOGURU_THREADNAME_WIDTH + 1] = {0};
+			if (s_async_draining && s_drain_thread_name) {
+				snprintf(thread_name, sizeof(thread_name), "%s", s_drain_thread_name); // Of whoever logged it.
+			} else {
+				get_thread_name(thread_name, sizeof(thread_name), false);
+			}
+			if (!glob_match(filter.thread.c_str(), thread_name)) { return false; }
+		}
+		if (filter.has_message && !std::regex_search(message.message, filter.message)) {
+			return false;
+		}
+		return true;
+	}
+
+	static bool filter_accepts_file(const CompiledFilter& filter, const char* file)
+	{
+		return filter.file.empty() || file_glob_match(filter.file.c_str(), file);
+	}
+
+	static bool filters_accept_uncached(const Callback& callback, const Message& message)
+	{
+		for (const auto& filter : callback.filters) {
+			if (filter_accepts_file(filter, message.filename) && filter_accepts_dynamic(filter, message)) {
+				return true;
+			}
+		}
+		return false;
+	}
+
+	// callsite is the file pointer passed by the logging call. It is only compared, never read.
+	static CallsiteRouting callsite_routing(const char* callsite, const char* file, unsigned line)
+	{
+		const CallsiteKey key{callsite, line};
+		auto it = s_callsite_routing.find(key);
+		if (it != s_callsite_routing.end()) {
+			return it->second;
+		}
+
+		CallsiteRouting routing{0, 0, false, Verbosity_OFF};
+		for (const auto& module : s_module_verbosities) {
+			if (file_glob_match(module.file_glob.c_str(), file)) {
+				routing.has_module_verbosity = true;
+				routing.module_verbosity = module.verbosity; // Last match wins.
+			}
+		}
+		for (size_t i = 0; i < s_callbacks.size() && i < MAX_CACHED_CALLBACKS; ++i) {
+			const auto bit = uint64_t(1) << i;
+			const auto& callback = s_callbacks[i];
+			if (callback.filters.empty()) {
+				routing.accept |= bit;
+				continue;
+			}
+			for (const auto& filter : callback.filters) {
+				if (filter_accepts_file(filter, file)) {
+					if (filter.thread.empty() && !filter.has_message) {
+						routing.accept |= bit;
+					} else {
+						routing.check |= bit;
+					}
+				}
+			}
+		}
+		s_callsite_routing[key] = routing;
+		return routing;
+	}
+
+	// Does the callback at the given index want this message? Verbosity is already checked.
+	static bool callback_accepts(size_t index, const Callback& callback, const Message& message,
+								 const CallsiteRouting& routing)
+	{
+		if (callback.filters.empty()) {
+			return true;
+		}
+		if (index >= MAX_CACHED_CALLBACKS) {
+			return filters_accept_uncached(callback, message);
+		}
+		const auto bit = uint64_t(1) << index;
+		if (routing.accept & bit) { return true; }
+		if ((routing.check & bit) == 0) { return false; }
+		for (const auto& filter : callback.filters) {
+			if (filter_accepts_file(filter, message.filename) && filter_accepts_dynamic(filter, message)) {
+				return true;
+			}
+		}
+		return false;
+	}
+
+	// ------------------------------------------------------------------------
+	// Each message is rendered once per distinct indentation, and the result is shared by all text sinks.
+	// The buffers are recycled through a free list, so steady-state logging does not allocate.
+	// Only touched with s_mutex held. A sink that logs recursively just borrows more buffers.
+
+	struct LineBuffer
+	{
+		const char* indentation; // indentation() returns one pointer per depth, so this is the key.
+		std::string text;
+	};
+
+	static std::vector<LineBuffer*> s_free_line_buffers;
+
+	class LineCache
+	{
+	public:
+		LineCache() : _num_lines(0) {}
+		~LineCache()
+		{
+			for (size_t i = 0; i < _num_lines; ++i) {
+				s_free_line_buffers.push_back(_lines[i]);
+			}
+		}
+		LineCache(const LineCache&) = delete;
+		LineCache& operator=(const LineCache&) = delete;
+
+		const std::string& get(const Message& message)
+		{
+			for (size_t i = 0; i < _num_lines; ++i) {
+				if (_lines[i]->indentation == message.indentation) {
+					return _lines[i]->text;
+				}
+			}
+
+			LineBuffer* line;
+			if (_num_lines < MAX_LINES) {
+				if (s_free_line_buffers.empty()) {
+					line = new LineBuffer();
+				} else {
+					line = s_free_line_buffers.back();
+					s_free_line_buffers.pop_back();
+				}
+				_lines[_num_lines++] = line;
+			} else {
+				line = _lines[MAX_LINES - 1]; // Pathological amount of indentations - re-render.
+			}
+
+			line->indentation = message.indentation;
+			line->text.clear();
+			line->text += message.preamble;
+			line->text += message.indentation;
+			line->text += message.context;
+			line->text += message.prefix;
+			line->text += message.message;
+			line->text += '\n';
+			return line->text;
+		}
+
+	private:
+		static const size_t MAX_LINES = 8;
+		LineBuffer* _lines[MAX_LINES];
+		size_t      _num_lines;
+	};
+
+	static void flush_outputs(bool all_batches);
+	static void flush_batches(bool all);
+
+	// stack_trace_skip is just if verbosity == FATAL.
+	// depths is where the message was logged (see ScopeDepths), or null for now.
+	// raised is the thread_verbosity() of the thread that logged it.
+	// callsite is the file pointer it was logged with, if message.filename is a copy (see callsite_routing).
+	static void log_message(int stack_trace_skip, Message& message, bool with_indentation, bool abort_if_fatal,
+							const ScopeDepths* depths = nullptr, Verbosity raised = Verbosity_OFF,
+							const char* callsite = nullptr)
+	{
+		const auto verbosity = message.verbosity;
+		std::lock_guard<LogMutex> lock(s_mutex);
+
+		if (message.verbosity == Verbosity_FATAL) {
+			auto st = loguru::stacktrace(stack_trace_skip + 2);
+			if (!st.empty()) {
+				RAW_LOG_F(ERROR, "Stack trace:\n%s", st.c_str());
+			}
+
+			auto ec = loguru::get_error_context();
+			if (!ec.empty()) {
+				RAW_LOG_F(ERROR, "%s", ec.c_str());
+			}
+		}
+
+		ScopeDepths current_depths;
+		if (with_indentation) {
+			if (!depths) {
+				current_scope_depths(&current_depths);
+				depths = &current_depths;
+			}
+			message.indentation = indentation(depths->stderr_depth);
+		}
+
+		const bool needs_routing = s_has_filters || !s_module_verbosities.empty();
+		const CallsiteRouting routing = needs_routing ? callsite_routing(callsite ? callsite : message.filename,
+																		 message.filename, message.line)
+													  : CallsiteRouting{~uint64_t(0), 0, false, Verbosity_OFF};
+		const Verbosity stderr_cutoff = routing.has_module_verbosity ? routing.module_verbosity
+																	 : stderr_verbosity();
+
+		LineCache lines;
+
+		if (verbosity <= stderr_cutoff) {
+			if (g_colorlogtostderr && s_terminal_has_color) {
+				if (verbosity > Verbosity_WARNING) {
+					fprintf(stderr, "%s%s%s%s%s%s%s%s%s%s\n",
+						terminal_reset(),
+						terminal_dim(),
+						message.preamble,
+						message.indentation,
+						message.context,
+						terminal_reset(),
+						verbosity == Verbosity_INFO ? terminal_bold() : terminal_light_gray(),
+						message.prefix,
+						message.message,
+						terminal_reset());
+				} else {
+					fprintf(stderr, "%s%s%s%s%s%s%s%s%s\n",
+						terminal_reset(),
+						terminal_bold(),
+						verbosity == Verbosity_WARNING ? terminal_red() : terminal_light_red(),
+						message.preamble,
+						message.indentation,
+						message.context,
+						message.prefix,
+						message.message,
+						terminal_reset());
+				}
+			} else {
+				const auto& line = lines.get(message);
+				fwrite(line.data(), 1, line.size(), stderr);
+			}
+
+			if (g_flush_interval_ms == 0 && !s_async_draining) {
+				fflush(stderr);
+			} else {
+				s_needs_flushing = true;
+			}
+		}
+
+		for (size_t i = 0; i < s_callbacks.size(); ++i) {
+			auto& p = s_callbacks[i];
+			const Verbosity sink_verbosity = std::max(p.verbosity, std::min(raised, p.raised_verbosity));
+			if (verbosity <= sink_verbosity && callback_accepts(i, p, message, routing)) {
+				if (with_indentation) {
+					message.indentation = indentation(sink_depth(*depths, sink_verbosity));
+				}
+				if (p.batch_callback) {
+					append_to_batch(p, message); // Flushed by the flusher when it hands the batch over.
+					continue;
+				}
+				if (p.line_callback) {
+					const auto& line = lines.get(message);
+					p.line_callback(p.user_data, message, line.data(), line.size());
+				} else {
+					p.callback(p.user_data, message);
+				}
+				if (g_flush_interval_ms == 0 && !s_async_draining) {
+					if (p.flush) { p.flush(p.user_data); }
+				} else {
+					s_needs_flushing = true;
+				}
+			}
+		}
+
+		if (s_config_restart_needed) {
+			start_config_watcher();
+		}
+
+		if ((g_flush_interval_ms > 0 || s_batch_tick_ms > 0) && !s_flush_thread) {
+			s_flush_thread = new std::thread([](){
+				for (;;) {
+					if (s_needs_flushing) {
+						flush_outputs(false);
+					} else if (s_batch_tick_ms > 0) {
+						flush_batches(false);
+					}
+					const unsigned interval = g_flush_interval_ms;
+					const unsigned batch_tick = s_batch_tick_ms;
+					std::this_thread::sleep_for(std::chrono::milliseconds(
+						interval == 0 ? std::max(batch_tick, 1u) : batch_tick == 0 ? interval : std::min(interval, batch_tick)));
+				}
+			});
+		}
+
+		if (message.verbosity == Verbosity_FATAL) {
+			flush();
+
+			if (s_fatal_handler) {
+				s_fatal_handler(message);
+				flush();
+			}
+
+			if (abort_if_fatal) {
+#if LOGURU_CATCH_SIGABRT && !defined(_WIN32)
+				// Make sure we don't catch our own abort:
+				signal(SIGABRT, SIG_DFL);
+#endif
+				abort();
+			}
+		}
+	}
+
+	// ------------------------------------------------------------------------
+	// Async logging:
+
+	/*  Each record is a header followed by its zero-terminated preamble, context, prefix, message and file name.
+		The file name is copied too: only the logging macros promise that it lives forever.
+		Producers append records to the active buffer of the shard for their CPU.
+		Draining swaps each active buffer with the spare one under the shard lock,
+		then writes out the records of all shards, merged by timestamp, with s_mutex held.
+		A thread that moves between CPUs spreads its records over several shards, and its timestamps may tie
+		(Clock_Coarse) or go backwards (a step of Clock_System), so the merge is by sort_ns and sequence. */
+	struct AsyncRecord
+	{
+		long long   timestamp_ns;
+		long long   sort_ns;  // timestamp_ns, but never less than that of the previous record of the producer.
+		uint64_t    sequence; // Counts the records of the producer, to order those with the same sort_ns.
+		const char* callsite; // The file pointer of the caller. Only a key for callsite_routing: never read.
+		unsigned    line;
+		Verbosity   verbosity;
+		Verbosity   raised; // thread_verbosity() of the producer.
+		unsigned    sample_rate;
+		bool        with_indentation;
+		ScopeDepths depths; // If with_indentation.
+		uint32_t    preamble_size;
+		uint32_t    context_size;
+		uint32_t    prefix_size;
+		uint32_t    message_size;
+		uint32_t    filename_size;
+		uint32_t    total_size; // Header and strings, rounded up to keep the next record aligned.
+		char        thread_name[LOGURU_THREADNAME_WIDTH + 1]; // Of the producer, if there are thread filters. Else "".
+	};
+
+	static Message record_message(const AsyncRecord* record)
+	{
+		const char* preamble = reinterpret_cast<const char*>(record + 1);
+		const char* context = preamble + record->preamble_size + 1;
+		const char* prefix = context + record->context_size + 1;
+		const char* text = prefix + record->prefix_size + 1;
+		const char* filename = text + record->message_size + 1;
+		return Message{record->verbosity, filename, record->line,
+					   preamble, "", prefix, text, record->timestamp_ns, record->sample_rate, context};
+	}
+
+	struct AsyncShard
+	{
+		std::atomic_flag lock = ATOMIC_FLAG_INIT;
+		char*            active = nullptr;
+		char*            spare  = nullptr;
+		size_t           used   = 0; // Bytes of active in use.
+		char             padding[64]; // Keep neighbouring shards off each others cache lines.
+	};
+
+	static void lock_shard(AsyncShard& shard)
+	{
+		while (shard.lock.test_and_set(std::memory_order_acquire)) {
+			std::this_thread::yield();
+		}
+	}
+
+	static bool lock_shard_before(AsyncShard& shard, steady_clock::time_point deadline)
+	{
+		while (shard.lock.test_and_set(std::memory_order_acquire)) {
+			if (steady_clock::now() >= deadline) { return false; }
+			std::this_thread::yield();
+		}
+		return true;
+	}
+
+	static void unlock_shard(AsyncShard& shard)
+	{
+		shard.lock.clear(std::memory_order_release);
+	}
+
+	static AsyncShard& current_shard()
+	{
+	#ifdef __linux__
+		// Recent glibc answers this from the rseq area without a system call.
+		const int cpu = sched_getcpu();
+		return s_async_shards[static_cast<size_t>(cpu < 0 ? 0 : cpu) % s_async_num_shards];
+	#else
+		static std::atomic<unsigned> s_next_shard { 0 };
+		static thread_local unsigned s_shard = s_next_shard++;
+		return s_async_shards[s_shard % s_async_num_shards];
+	#endif
+	}
+
+	static void async_thread_main();
+
+	// Called with s_mutex held.
+	static void start_async_thread()
+	{
+		s_async_needs_thread = false;
+		s_async_thread = new std::thread(async_thread_main);
+	}
+
+	/*  Writes out everything pending. Returns false if called recursively from a sink.
+		A shard whose lock is not ours by the deadline is read in place:
+		its owner is stuck (or is us, interrupted by a signal), and we are about to die. */
+	static bool async_drain(steady_clock::time_point deadline = steady_clock::time_point::max())
+	{
+		std::lock_guard<LogMutex> lock(s_mutex);
+		if (!s_async_shards || s_async_stuck) { return true; }
+		if (s_async_draining) { return false; }
+		s_async_draining = true;
+
+		// Take all shards at once: a producer that moves between CPUs during the drain must not get
+		// a newer record into this drain and an older one into the next.
+		std::vector<char> locked(s_async_num_shards);
+		for (size_t i = 0; i < s_async_num_shards; ++i) {
+			locked[i] = lock_shard_before(s_async_shards[i], deadline);
+			if (!locked[i]) {
+				s_async_stuck = true; // Never wait for it again.
+			}
+		}
+		std::vector<std::pair<const char*, size_t>> buffers(s_async_num_shards);
+		for (size_t i = 0; i < s_async_num_shards; ++i) {
+			auto& shard = s_async_shards[i];
+			if (locked[i]) {
+				std::swap(shard.active, shard.spare);
+				buffers[i] = { shard.spare, shard.used };
+				shard.used = 0;
+			} else {
+				// Read in place. used is only ever bumped after a whole record is written.
+				buffers[i] = { shard.active, shard.used };
+			}
+		}
+		for (size_t i = 0; i < s_async_num_shards; ++i) {
+			if (locked[i]) { unlock_shard(s_async_shards[i]); }
+		}
+
+		std::vector<const AsyncRecord*> records;
+		for (const auto& buffer : buffers) {
+			for (size_t offset = 0; offset < buffer.second; ) {
+				const auto record = reinterpret_cast<const AsyncRecord*>(buffer.first + offset);
+				records.push_back(record);
+				offset += record->total_size;
+			}
+		}
+
+		std::stable_sort(records.begin(), records.end(), [](const AsyncRecord* a, const AsyncRecord* b) {
+			return a->sort_ns < b->sort_ns || (a->sort_ns == b->sort_ns && a->sequence < b->sequence);
+		});
+
+		for (const auto record : records) {
+			auto message = record_message(record);
+			s_drain_thread_name = record->thread_name[0] ? record->thread_name : nullptr;
+			log_message(1, message, record->with_indentation, false, &record->depths, record->raised, record->callsite);
+		}
+		s_drain_thread_name = nullptr;
+
+		s_async_draining = false;
+		if (!records.empty() && g_flush_interval_ms == 0) {
+			flush_outputs(false);
+		}
+		return true;
+	}
+
+	// Returns false if the message should be written synchronously instead.
+	static bool async_enqueue(const Message& message, bool with_indentation)
+	{
+		if (!s_async_enabled.load(std::memory_order_relaxed) ||
+			message.verbosity <= s_async_priority_verbosity.load(std::memory_order_relaxed)) {
+			return false;
+		}
+
+		const size_t preamble_size = strlen(message.preamble);
+		const size_t context_size = strlen(message.context);
+		const size_t prefix_size = strlen(message.prefix);
+		const size_t message_size = strlen(message.message);
+		const size_t filename_size = strlen(message.filename);
+		const size_t total_size = (sizeof(AsyncRecord) + preamble_size + context_size + prefix_size + message_size +
+								   filename_size + 5 +
+								   alignof(AsyncRecord) - 1) & ~(alignof(AsyncRecord) - 1);
+		if (total_size > s_async_shard_size) {
+			return false; // Will never fit.
+		}
+
+		// Thread filters are checked when draining, on another thread, so remember who we are:
+		char thread_name[LOGURU_THREADNAME_WIDTH + 1] = {0};
+		if (s_has_thread_filters.load(std::memory_order_relaxed)) {
+			get_thread_name(thread_name, sizeof(thread_name), false);
+		}
+
+		ScopeDepths depths;
+		if (with_indentation) {
+			current_scope_depths(&depths);
+		}
+
+		static thread_local long long s_last_sort_ns = 0;
+		static thread_local uint64_t  s_sequence     = 0;
+		s_last_sort_ns = std::max(s_last_sort_ns, message.timestamp_ns);
+		const long long sort_ns = s_last_sort_ns;
+		const uint64_t sequence = s_sequence++;
+
+		if (s_async_needs_thread.load(std::memory_order_relaxed)) {
+			std::lock_guard<LogMutex> lock(s_mutex);
+			if (s_async_needs_thread) {
+				start_async_thread();
+			}
+		}
+
+		for (;;) {
+			auto& shard = current_shard();
+			lock_shard(shard);
+			if (shard.used + total_size <= s_async_shard_size) {
+				char* out = shard.active + shard.used;
+				auto record = reinterpret_cast<AsyncRecord*>(out);
+				record->timestamp_ns     = message.timestamp_ns;
+				record->sort_ns          = sort_ns;
+				record->sequence         = sequence;
+				record->callsite         = message.filename;
+				record->line             = message.line;
+				record->verbosity        = message.verbosity;
+				record->raised           = s_thread_verbosity;
+				record->sample_rate      = message.sample_rate;
+				record->with_indentation = with_indentation;
+				if (with_indentation) {
+					record->depths = depths;
+				}
+				record->preamble_size    = static_cast<uint32_t>(preamble_size);
+				record->context_size     = static_cast<uint32_t>(context_size);
+				record->prefix_size      = static_cast<uint32_t>(prefix_size);
+				record->message_size     = static_cast<uint32_t>(message_size);
+				record->filename_size    = static_cast<uint32_t>(filename_size);
+				record->total_size       = static_cast<uint32_t>(total_size);
+				memcpy(record->thread_name, thread_name, sizeof(thread_name));
+				out += sizeof(AsyncRecord);
+				memcpy(out, message.preamble, preamble_size + 1);
+				out += preamble_size + 1;
+				memcpy(out, message.context, context_size + 1);
+				out += context_size + 1;
+				memcpy(out, message.prefix, prefix_size + 1);
+				out += prefix_size + 1;
+				memcpy(out, message.message, message_size + 1);
+				out += message_size + 1;
+				memcpy(out, message.filename, filename_size + 1);
+				shard.used += total_size;
+				const bool half_full = shard.used > s_async_shard_size / 2;
+				unlock_shard(shard);
+
+				if (half_full && !s_async_wake_requested.exchange(true)) {
+					s_async_wake.notify_one();
+				}
+				return true;
+			}
+			unlock_shard(shard);
+
+			// Full. Make room by writing out everything ourselves:
+			if (!async_drain()) {
+				return false; // We are a sink logging from within a drain.
+			}
+		}
+	}
+
+	static void async_thread_main()
+	{
+		set_thread_name("loguru async");
+		for (;;) {
+			{
+				std::unique_lock<std::mutex> lock(s_async_wake_mutex);
+				s_async_wake.wait_for(lock, std::chrono::milliseconds(s_async_latency_ms), [](){
+					return s_async_wake_requested.load();
+				});
+				s_async_wake_requested = false;
+			}
+			async_drain();
+		}
+	}
+
+	// Allocates all shard buffers as one block that is never freed. Returns a description of how.
+	static char* allocate_async_memory(size_t size, unsigned flags, std::string* out_how)
+	{
+	#ifdef _WIN32
+		char* memory = new char[size];
+		if (flags & AsyncMemory_Populate) {
+			memset(memory, 0, size);
+			*out_how = "populated";
+		} else {
+			*out_how = "heap";
+		}
+		if (flags & (AsyncMemory_HugePages | AsyncMemory_Lock)) {
+			LOG_F(WARNING, "Huge pages and locked memory for async logging are not supported on Windows");
+		}
+		return memory;
+	#else
+		int populate = 0;
+		#ifdef MAP_POPULATE
+			if (flags & AsyncMemory_Populate) { populate = MAP_POPULATE; }
+		#endif
+
+		void* memory = MAP_FAILED;
+		*out_how = "mmap";
+		#ifdef MAP_HUGETLB
+			if (flags & AsyncMemory_HugePages) {
+				memory = mmap(nullptr, size, PROT_READ | PROT_WRITE,
+							  MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB | populate, -1, 0);
+				if (memory != MAP_FAILED) { *out_how = "hugetlb"; }
+			}
+		#endif
+		if (memory == MAP_FAILED) {
+			memory = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | populate, -1, 0);
+			CHECK_F(memory != MAP_FAILED, "Failed to allocate %u bytes for async logging: %s",
+					(unsigned)size, errno_as_text().c_str());
+			if (flags & AsyncMemory_HugePages) {
+			#ifdef MADV_HUGEPAGE
+				if (madvise(memory, size, MADV_HUGEPAGE) == 0) {
+					*out_how = "transparent huge pages";
+				} else
+			#endif
+				{
+					LOG_F(WARNING, "No huge pages available for async logging");
+				}
+			}
+		}
+		if (flags & AsyncMemory_Populate) {
+			*out_how += ", populated";
+			if (!populate) {
+				memset(memory, 0, size);
+			}
+		}
+		if (flags & AsyncMemory_Lock) {
+			if (mlock(memory, size) == 0) {
+				*out_how += ", locked";
+			} else {
+				LOG_F(WARNING, "Failed to mlock the async log buffers: %s", errno_as_text().c_str());
+			}
+		}
+		return static_cast<char*>(memory);
+	#endif
+	}
+
+	void start_async(unsigned shard_size, unsigned max_latency_ms, unsigned memory_flags)
+	{
+		std::lock_guard<LogMutex> lock(s_mutex);
+		install_fork_handlers();
+		s_async_latency_ms = std::max(1u, max_latency_ms);
+		if (!s_async_shards) {
+			const unsigned num_cpus = std::thread::hardware_concurrency();
+			s_async_num_shards = num_cpus > 0 ? num_cpus : 1;
+			s_async_shard_size = (std::max<size_t>(shard_size, 4096) + 4095) & ~size_t(4095); // Whole pages.
+			const size_t total_size = 2 * s_async_num_shards * s_async_shard_size;
+			std::string how;
+			char* memory = allocate_async_memory(total_size, memory_flags, &how);
+			s_async_shards = new AsyncShard[s_async_num_shards];
+			for (size_t i = 0; i < s_async_num_shards; ++i) {
+				s_async_shards[i].active = memory + (2 * i + 0) * s_async_shard_size;
+				s_async_shards[i].spare  = memory + (2 * i + 1) * s_async_shard_size;
+			}
+			LOG_F(INFO, "Async logging: %u shards of %u KiB, %.1f MiB in total (%s)", (unsigned)s_async_num_shards,
+				  (unsigned)(s_async_shard_size / 1024), total_size / (1024.0 * 1024.0), how.c_str());
+		} else if (shard_size != s_async_shard_size) {
+			LOG_F(WARNING, "start_async: keeping the original shard size of %u bytes", (unsigned)s_async_shard_size);
+		}
+		if (!s_async_thread) {
+			start_async_thread();
+		}
+		s_async_enabled = true;
+	}
+
+	void stop_async()
+	{
+		s_async_enabled = false;
+		async_drain();
+	}
+
+	void set_async_priority_verbosity(Verbosity verbosity)
+	{
+		s_async_priority_verbosity = std::max<int>(verbosity, Verbosity_FATAL);
+	}
+
+	static void lock_all_shards()
+	{
+		for (size_t i = 0; i < s_async_num_shards; ++i) {
+			lock_shard(s_async_shards[i]);
+		}
+	}
+
+	static void unlock_all_shards()
+	{
+		for (size_t i = 0; i < s_async_num_shards; ++i) {
+			unlock_shard(s_async_shards[i]);
+		}
+	}
+
+	// With all shards locked.
+	static void discard_async_records()
+	{
+		for (size_t i = 0; i < s_async_num_shards; ++i) {
+			s_async_shards[i].used = 0;
+		}
+	}
+
+	static void write_raw_to_stderr(const Message& message)
+	{
+		fprintf(stderr, "%s%s%s%s\n", message.preamble, message.context, message.prefix, message.message);
+	}
+
+	/*  Used on FATAL, CHECK failures and signals, right before we die.
+		Stops the producers, then writes out the pending records of all threads,
+		giving up on any lock not ours within LOGURU_EMERGENCY_DRAIN_MS.
+		If all went well, *resume lets the producers go again once the FATAL is written,
+		in case a fatal handler throws and we live on.
+		On success, lock holds s_mutex. Returns false if s_mutex was stuck elsewhere:
+		the records then went straight to stderr, and logging normally would hang. */
+	struct AsyncResume
+	{
+		bool resume = false;
+		~AsyncResume() { if (resume) { s_async_enabled = true; } }
+	};
+
+	static bool emergency_drain(std::unique_lock<LogMutex>& lock, AsyncResume* resume = nullptr)
+	{
+		if (!s_async_shards) { return true; }
+		// Until we are done everyone logs synchronously, i.e. waits for us:
+		const bool was_enabled = s_async_enabled.exchange(false);
+		const auto deadline = steady_clock::now() + milliseconds(LOGURU_EMERGENCY_DRAIN_MS);
+		while (!lock.try_lock()) {
+			if (steady_clock::now() >= deadline) {
+				for (size_t i = 0; i < s_async_num_shards; ++i) {
+					auto& shard = s_async_shards[i];
+					const bool locked = lock_shard_before(shard, deadline);
+					for (size_t offset = 0; offset < shard.used; ) {
+						const auto record = reinterpret_cast<const AsyncRecord*>(shard.active + offset);
+						write_raw_to_stderr(record_message(record));
+						offset += record->total_size;
+					}
+					if (locked) {
+						shard.used = 0;
+						unlock_shard(shard);
+					}
+				}
+				return false;
+			}
+			std::this_thread::sleep_for(microseconds(100));
+		}
+		async_drain(deadline);
+		if (resume) {
+			resume->resume = was_enabled && !s_async_stuck; // Only stay synchronous if something is stuck.
+		}
+		return true;
+	}
+
+	// ------------------------------------------------------------------------
+	// LOG_BUFFER_SCOPE:
+
+	// Where a held back message was logged, so each sink indents it as if it were written right away.
+	struct HeldOrigin
+	{
+		bool        with_indentation;
+		ScopeDepths depths; // If with_indentation.
+		Verbosity   raised; // thread_verbosity() when it was logged.
+	};
+
+	struct LogBuffer
+	{
+		MessageStore held;        // Oldest first.
+		std::vector<HeldOrigin> origins; // One per entry of held.
+		Verbosity    hold_above;  // Messages more verbose than this are held.
+		unsigned     num_dropped; // Messages that did not fit.
+		bool         tripped;     // A WARNING or worse was logged, so the rest of the scope is written directly.
+	};
+
+	// Set during the outermost LOG_BUFFER_SCOPE of the thread.
+	static thread_local LogBuffer* s_thread_log_buffer = nullptr;
+
+	static LogBuffer& thread_log_buffer()
+	{
+		static thread_local LogBuffer s_buffer; // Reused by each scope, and so is its memory.
+		return s_buffer;
+	}
+
+	LogBufferScope::LogBufferScope(Verbosity max_verbosity, Verbosity hold_above)
+		: _verbosity(max_verbosity)
+		, _owner(s_thread_log_buffer == nullptr)
+	{
+		if (_owner) {
+			auto& buffer = thread_log_buffer();
+			buffer.held.clear();
+			buffer.origins.clear();
+			buffer.hold_above = std::max<Verbosity>(hold_above, Verbosity_WARNING); // WARNING and worse trip the scope.
+			buffer.num_dropped = 0;
+			buffer.tripped = false;
+			s_thread_log_buffer = &buffer;
+		}
+	}
+
+	LogBufferScope::~LogBufferScope()
+	{
+		if (_owner) {
+			s_thread_log_buffer->held.clear(); // All went well.
+			s_thread_log_buffer->origins.clear();
+			s_thread_log_buffer = nullptr;
+		}
+	}
+
+	// Returns true if the message was held back by a LOG_BUFFER_SCOPE.
+	static bool hold_back(const Message& message, bool with_indentation)
+	{
+		LogBuffer* buffer = s_thread_log_buffer;
+		if (!buffer || buffer->tripped) {
+			return false;
+		}
+		if (message.verbosity > buffer->hold_above) {
+			if (buffer->held.storage.size() < LOGURU_LOG_BUFFER_SIZE) {
+				HeldOrigin origin;
+				origin.with_indentation = with_indentation;
+				if (with_indentation) {
+					current_scope_depths(&origin.depths); // The scopes may have closed by the time it is written out.
+				}
+				origin.raised = s_thread_verbosity;
+				buffer->held.add(message);
+				buffer->origins.push_back(origin);
+			} else {
+				buffer->num_dropped += 1;
+			}
+			return true;
+		}
+		if (message.verbosity <= Verbosity_WARNING) {
+			buffer->tripped = true;
+			std::lock_guard<LogMutex> lock(s_mutex);
+			async_drain(); // What was written as usual during the scope comes first.
+			for (size_t i = 0; i < buffer->held.entries.size(); ++i) {
+				auto held = buffer->held.get(i);
+				const auto& origin = buffer->origins[i];
+				log_message(1, held, origin.with_indentation, false, &origin.depths, origin.raised);
+			}
+			buffer->held.clear();
+			buffer->origins.clear();
+			if (buffer->num_dropped > 0) {
+				LOG_F(WARNING, "LOG_BUFFER_SCOPE dropped %u messages that did not fit in LOGURU_LOG_BUFFER_SIZE",
+					  buffer->num_dropped);
+			}
+		}
+		return false;
+	}
+
+	static void dispatch_message(int stack_trace_skip, Message& message, bool with_indentation)
+	{
+		if (hold_back(message, with_indentation)) {
+			return;
+		}
+		if (async_enqueue(message, with_indentation)) {
+			return;
+		}
+		AsyncResume resume_async; // After the lock is released, even if the fatal handler throws.
+		std::unique_lock<LogMutex> lock(s_mutex, std::defer_lock);
+		if (message.verbosity == Verbosity_FATAL && !emergency_drain(lock, &resume_async)) {
+			write_raw_to_stderr(message);
+			fprintf(stderr, "loguru: the log lock is stuck; aborting without the fatal handler\n");
+#if LOGURU_CATCH_SIGABRT && !defined(_WIN32)
+			signal(SIGABRT, SIG_DFL);
+#endif
+			abort();
+		}
+		// The priority lane, or too big for a shard: keep the order by writing out what is pending first.
+		const bool async_enabled = s_async_enabled.load(std::memory_order_relaxed);
+		const bool priority = message.verbosity == Verbosity_FATAL ||
+			(async_enabled && message.verbosity <= s_async_priority_verbosity.load(std::memory_order_relaxed));
+		if (priority || async_enabled) {
+			async_drain();
+		}
+		log_message(stack_trace_skip + 1, message, with_indentation, true, nullptr, s_thread_verbosity);
+		if (priority && g_flush_interval_ms != 0) {
+			// Unbuffered log_message already flushed. Partial batches wait until they are due:
+			flush_outputs(false);
+		}
+	}
+
+	// ------------------------------------------------------------------------
+	// LOG_CONTEXT:
+
+	struct LogContext
+	{
+		std::string tags;     // E.g. "req=42 tenant=\"acme\"".
+		std::string rendered; // E.g. "[req=42 tenant=\"acme\"] ", or "". What goes into each message.
+	};
+
+	static LogContext& thread_log_context()
+	{
+		static thread_local LogContext s_context;
+		return s_context;
+	}
+
+	static void render_log_context(LogContext& context)
+	{
+		context.rendered.clear();
+		if (!context.tags.empty()) {
+			context.rendered += '[';
+			context.rendered += context.tags;
+			context.rendered += "] ";
+		}
+	}
+
+	LogContextScope::LogContextScope(const char* key, Text value)
+	{
+		auto& context = thread_log_context();
+		_previous_size = static_cast<unsigned>(context.tags.size());
+		if (!context.tags.empty()) {
+			context.tags += ' ';
+		}
+		context.tags += key;
+		context.tags += '=';
+		context.tags += value.c_str();
+		render_log_context(context);
+	}
+
+	LogContextScope::~LogContextScope()
+	{
+		auto& context = thread_log_context();
+		context.tags.resize(_previous_size);
+		render_log_context(context);
+	}
+
+	const char* get_log_context()
+	{
+		return thread_log_context().tags.c_str();
+	}
+
+	// stack_trace_skip is just if verbosity == FATAL.
+	void log_to_everywhere(int stack_trace_skip, Verbosity verbosity,
+						   const char* file, unsigned line,
+						   const char* prefix, const char* buff, unsigned sample_rate = 1)
+	{
+		const auto timestamp = now_timestamp(preamble_needs_uptime());
+		char preamble_buff[128];
+		print_preamble(preamble_buff, sizeof(preamble_buff), timestamp, verbosity, file, line);
+		char sample_prefix[32];
+		if (sample_rate > 1) {
+			snprintf(sample_prefix, sizeof(sample_prefix), "[1/%u] ", sample_rate);
+			prefix = sample_prefix;
+		}
+		auto message = Message{verbosity, file, line, preamble_buff, "", prefix, buff, timestamp.epoch_ns, sample_rate,
+							   thread_log_context().rendered.c_str()};
+		dispatch_message(stack_trace_skip + 1, message, true);
+	}
+
+	// ------------------------------------------------------------------------
+	// Sampling:
+
+	// Index is verbosity. 0 or 1 means 'log everything'.
+	static std::atomic<unsigned> s_sample_rates[Verbosity_MAX + 1];
+
+	void set_sample_rate(Verbosity verbosity, unsigned one_in_n)
+	{
+		if (verbosity < 1 || verbosity > Verbosity_MAX) {
+			LOG_F(ERROR, "set_sample_rate: can only sample verbosity 1-%d, got %d", Verbosity_MAX, verbosity);
+			return;
+		}
+		s_sample_rates[verbosity].store(one_in_n, std::memory_order_relaxed);
+	}
+
+	static unsigned sample_rate_for(Verbosity verbosity)
+	{
+		if (verbosity < 1 || verbosity > Verbosity_MAX) {
+			return 1;
+		}
+		return std::max(1u, s_sample_rates[verbosity].load(std::memory_order_relaxed));
+	}
+
+	bool sample(unsigned one_in_n)
+	{
+		if (one_in_n <= 1) {
+			return true;
+		}
+		// xorshift64*, seeded per thread.
+		static thread_local uint64_t state = 0;
+		if (state == 0) {
+			state = static_cast<uint64_t>(steady_clock::now().time_since_epoch().count()) ^
+					reinterpret_cast<uintptr_t>(&state) ^ 0x9E3779B97F4A7C15ull;
+			if (state == 0) { state = 1; }
+		}
+		state ^= state >> 12;
+		state ^= state << 25;
+		state ^= state >> 27;
+		const uint64_t random = (state * 0x2545F4914F6CDD1Dull) >> 32;
+		return ((random * one_in_n) >> 32) == 0;
+	}
+
+#if LOGURU_USE_FMTLIB
+	void log(Verbosity verbosity, const char* file, unsigned line, const char* format, fmt::ArgList args)
+	{
+		const unsigned sample_rate = sample_rate_for(verbosity);
+		if (sample_rate > 1 && !sample(sample_rate)) {
+			return;
+		}
+		auto formatted = fmt::format(format, args);
+		log_to_everywhere(1, verbosity, file, line, "", formatted.c_str(), sample_rate);
+	}
+
+	void log_sampled(unsigned one_in_n, Verbosity verbosity, const char* file, unsigned line, const char* format, fmt::ArgList args)
+	{
+		auto formatted = fmt::format(format, args);
+		log_to_everywhere(1, verbosity, file, line, "", formatted.c_str(), std::max(1u, one_in_n));
+	}
+
+	void raw_log(Verbosity verbosity, const char* file, unsigned line, const char* format, fmt::ArgList args)
+	{
+		auto formatted = fmt::format(format, args);
+		auto message = Message{verbosity, file, line, "", "", "", formatted.c_str(), timestamp_ns(), 1, ""};
+		dispatch_message(1, message, false);
+	}
+
+#else
+	void log(Verbosity verbosity, const char* file, unsigned line, const char* format, ...)
+	{
+		const unsigned sample_rate = sample_rate_for(verbosity);
+		if (sample_rate > 1 && !sample(sample_rate)) {
+			return;
+		}
+		va_list vlist;
+		va_start(vlist, format);
+		auto buff = vtextprintf_scratch(format, vlist);
+		log_to_everywhere(1, verbosity, file, line, "", buff.c_str(), sample_rate);
+		va_end(vlist);
+	}
+
+	void log_sampled(unsigned one_in_n, Verbosity verbosity, const char* file, unsigned line, const char* format, ...)
+	{
+		va_list vlist;
+		va_start(vlist, format);
+		auto buff = vtextprintf_scratch(format, vlist);
+		log_to_everywhere(1, verbosity, file, line, "", buff.c_str(), std::max(1u, one_in_n));
+		va_end(vlist);
+	}
+
+	void raw_log(Verbosity verbosity, const char* file, unsigned line, const char* format, ...)
+	{
+		va_list vlist;
+		va_start(vlist, format);
+		auto buff = vtextprintf_scratch(format, vlist);
+		auto message = Message{verbosity, file, line, "", "", "", buff.c_str(), timestamp_ns(), 1, ""};
+		dispatch_message(1, message, false);
+		va_end(vlist);
+	}
+#endif
+
+	// Hands batches over to their callbacks. Only the due batches, unless all.
+	static void flush_batches(bool all)
+	{
+		std::lock_guard<LogMutex> lock(s_mutex);
+		for (size_t i = 0; i < s_callbacks.size(); ++i) {
+			if (s_callbacks[i].batch && (all || batch_due(*s_callbacks[i].batch))) {
+				deliver_batch(s_callbacks[i]);
+			}
+		}
+	}
+
+	static void flush_outputs(bool all_batches)
+	{
+		std::lock_guard<LogMutex> lock(s_mutex);
+		if (!s_async_draining) {
+			async_drain();
+		}
+		fflush(stderr);
+		for (const auto& callback : s_callbacks)
+		{
+			if (callback.flush && !callback.batch) {
+				callback.flush(callback.user_data);
+			}
+		}
+		flush_batches(all_batches);
+		s_needs_flushing = false;
+	}
+
+	void flush()
+	{
+		flush_outputs(true);
+	}
+
+	static void log_scope_line(Verbosity verbosity, const char* file, unsigned line, const char* prefix, const char* text)
+	{
+		const auto timestamp = now_timestamp(preamble_needs_uptime());
+		char preamble_buff[128];
+		print_preamble(preamble_buff, sizeof(preamble_buff), timestamp, verbosity, file, line);
+		auto message = Message{verbosity, file, line, preamble_buff, "", prefix, text, timestamp.epoch_ns, 1,
+							   thread_log_context().rendered.c_str()};
+		dispatch_message(1, message, true);
+	}
+
+	// The indentation is tracked by atomics, and async records carry a snapshot of it,
+	// so scopes never need to wait for the pending records to be written out.
+	LogScopeRAII::LogScopeRAII(Verbosity verbosity, const char* file, unsigned line, const char* format, ...)
+		: _verbosity(verbosity), _file(file), _line(line)
+	{
+		if (verbosity <= current_verbosity_cutoff()) {
+			_indent_stderr = (verbosity <= stderr_verbosity());
+			_start_time_ns = now_ns();
+			va_list vlist;
+			va_start(vlist, format);
+			vsnprintf(_name, sizeof(_name), format, vlist);
+			log_scope_line(_verbosity, file, line, "{ ", _name);
+			va_end(vlist);
+
+			if (_indent_stderr) {
+				++s_stderr_indentation;
+			}
+			auto& open_scopes = s_open_scopes[scope_verbosity_index(verbosity)];
+			if (open_scopes.load(std::memory_order_relaxed) < 255) {
+				++open_scopes;
+			}
+		} else {
+			_file = nullptr;
+		}
+	}
+
+	LogScopeRAII::~LogScopeRAII()
+	{
+		if (_file) {
+			if (_indent_stderr && s_stderr_indentation > 0) {
+				--s_stderr_indentation;
+			}
+			auto& open_scopes = s_open_scopes[scope_verbosity_index(_verbosity)];
+			if (open_scopes.load(std::memory_order_relaxed) > 0) {
+				--open_scopes;
+			}
+			auto duration_sec = (now_ns() - _start_time_ns) / 1e9;
+			auto buff = textprintf("} %.*f s: %s", SCOPE_TIME_PRECISION, duration_sec, _name);
+			log_scope_line(_verbosity, _file, _line, "", buff.c_str());
+		}
+	}
+
+	void log_and_abort(int stack_trace_skip, const char* expr, const char* file, unsigned line, const char* format, ...)
+	{
+		va_list vlist;
+		va_start(vlist, format);
+		auto buff = vtextprintf_scratch(format, vlist);
+		log_to_everywhere(stack_trace_skip + 1, Verbosity_FATAL, file, line, expr, buff.c_str());
+		va_end(vlist);
+		abort(); // log_to_everywhere already does this, but this makes the analyzer happy.
+	}
+
+	void log_and_abort(int stack_trace_skip, const char* expr, const char* file, unsigned line)
+	{
+		log_and_abort(stack_trace_skip + 1, expr, file, line, " ");
+	}
+
+	// ----------------------------------------------------------------------------
+	// Streams:
+
+	std::string vstrprintf(const char* format, va_list vlist)
+	{
+		auto text = vtextprintf(format, vlist);
+		std::string result = text.c_str();
+		return result;
+	}
+
+	std::string strprintf(const char* format, ...)
+	{
+		va_list vlist;
+		va_start(vlist, format);
+		auto result = vstrprintf(format, vlist);
+		va_end(vlist);
+		return result;
+	}
+
+	#if LOGURU_WITH_STREAMS
+
+	std::string& StreamBuffer::str()
+	{
+		_str.append(pbase(), pptr());
+		setp(_buff, _buff + sizeof(_buff));
+		return _str;
+	}
+
+	StreamBuffer::int_type StreamBuffer::overflow(int_type ch)
+	{
+		_str.append(pbase(), pptr());
+		setp(_buff, _buff + sizeof(_buff));
+		if (!traits_type::eq_int_type(ch, traits_type::eof())) {
+			_str.push_back(traits_type::to_char_type(ch));
+		}
+		return traits_type::not_eof(ch);
+	}
+
+	StreamLogger::~StreamLogger() noexcept(false)
+	{
+		auto message = _buffer.str();
+		log(_verbosity, _file, _line, "%s", message.c_str());
+	}
+
+	AbortLogger::~AbortLogger() noexcept(false)
+	{
+		auto message = _buffer.str();
+		loguru::log_and_abort(1, _expr, _file, _line, "%s", message.c_str());
+	}
+
+	#endif // LOGURU_WITH_STREAMS
+
+	// ----------------------------------------------------------------------------
+	// 888888 88""Yb 88""Yb  dP"Yb  88""Yb      dP""b8  dP"Yb  88b 88 888888 888888 Yb  dP 888888
+	// 88__   88__dP 88__dP dP   Yb 88__dP     dP   `" dP   Yb 88Yb88   88   88__    YbdP    88
+	// 88""   88"Yb  88"Yb  Yb   dP 88"Yb      Yb      Yb   dP 88 Y88   88   88""    dPYb    88
+	// 888888 88  Yb 88  Yb  YbodP  88  Yb      YboodP  YbodP  88  Y8   88   888888 dP  Yb   88
+	// ----------------------------------------------------------------------------
+
+	struct StringStream
+	{
+		std::string str;
+	};
+
+	// Use this in your EcPrinter implementations.
+	void stream_print(StringStream& out_string_stream, const char* text)
+	{
+		out_string_stream.str += text;
+	}
+
+	// ----------------------------------------------------------------------------
+
+	using ECPtr = EcEntryBase*;
+
+#if defined(_WIN32) || (defined(__APPLE__) && !TARGET_OS_IPHONE)
+	#ifdef __APPLE__
+		#define LOGURU_THREAD_LOCAL __thread
+	#else
+		#define LOGURU_THREAD_LOCAL thread_local
+	#endif
+	static LOGURU_THREAD_LOCAL ECPtr thread_ec_ptr = nullptr;
+
+	ECPtr& get_thread_ec_head_ref()
+	{
+		return thread_ec_ptr;
+	}
+#else // !thread_local
+	static pthread_once_t s_ec_pthread_once = PTHREAD_ONCE_INIT;
+	static pthread_key_t  s_ec_pthread_key;
+
+	void free_ec_head_ref(void* io_error_context)
+	{
+		delete reinterpret_cast<ECPtr*>(io_error_context);
+	}
+
+	void ec_make_pthread_key()
+	{
+		(void)pthread_key_create(&s_ec_pthread_key, free_ec_head_ref);
+	}
+
+	ECPtr& get_thread_ec_head_ref()
+	{
+		(void)pthread_once(&s_ec_pthread_once, ec_make_pthread_key);
+		auto ec = reinterpret_cast<ECPtr*>(pthread_getspecific(s_ec_pthread_key));
+		if (ec == nullptr) {
+			ec = new ECPtr(nullptr);
+			(void)pthread_setspecific(s_ec_pthread_key, ec);
+		}
+		return *ec;
+	}
+#endif // !thread_local
+
+	// ----------------------------------------------------------------------------
+
+	EcHandle get_thread_ec_handle()
+	{
+		return get_thread_ec_head_ref();
+	}
+
+	Text get_error_context()
+	{
+		return get_error_context_for(get_thread_ec_head_ref());
+	}
+
+	Text get_error_context_for(const EcEntryBase* ec_head)
+	{
+		std::vector<const EcEntryBase*> stack;
+		while (ec_head) {
+			stack.push_back(ec_head);
+			ec_head = ec_head->_previous;
+		}
+		std::reverse(stack.begin(), stack.end());
+
+		StringStream result;
+		if (!stack.empty()) {
+			result.str += "------------------------------------------------\n";
+			for (auto entry : stack) {
+				const auto description = std::string(entry->_descr) + ":";
+				auto prefix = textprintf("[ErrorContext] %*s:%-5u %-20s ",
+					LOGURU_FILENAME_WIDTH, filename(entry->_file), entry->_line, description.c_str());
+				result.str += prefix.c_str();
+				entry->print_value(result);
+				result.str += "\n";
+			}
+			result.str += "------------------------------------------------";
+		}
+		return Text::copy(result.str.c_str());
+	}
+
+	EcEntryBase::EcEntryBase(const char* file, unsigned line, const char* descr)
+		: _file(file), _line(line), _descr(descr)
+	{
+		EcEntryBase*& ec_head = get_thread_ec_head_ref();
+		_previous = ec_head;
+		ec_head = this;
+	}
+
+	EcEntryBase::~EcEntryBase()
+	{
+		get_thread_ec_head_ref() = _previous;
+	}
+
+	// ------------------------------------------------------------------------
+
+	Text ec_to_text(const char* value)
+	{
+		// Add quotes around the string to make it obvious where it begin and ends.
+		// This is great for detecting erroneous leading or trailing spaces in e.g. an identifier.
+		auto str = "\"" + std::string(value) + "\"";
+		return Text::copy(str.c_str());
+	}
+
+	Text ec_to_text(char c)
+	{
+		// Add quotes around the character to make it obvious where it begin and ends.
+		std::string str = "'";
+
+		auto write_hex_digit = [&](unsigned num)
+		{
+			if (num < 10u) { str += char('0' + num); }
+			else           { str += char('a' + num - 10); }
+		};
+
+		auto write_hex_16 = [&](uint16_t n)
+		{
+			write_hex_digit((n >> 12u) & 0x0f);
+			write_hex_digit((n >>  8u) & 0x0f);
+			write_hex_digit((n >>  4u) & 0x0f);
+			write_hex_digit((n >>  0u) & 0x0f);
+		};
+
+		if      (c == '\\') { str += "\\\\"; }
+		else if (c == '\"') { str += "\\\""; }
+		else if (c == '\'') { str += "\\\'"; }
+		else if (c == '\0') { str += "\\0";  }
+		else if (c == '\b') { str += "\\b";  }
+		else if (c == '\f') { str += "\\f";  }
+		else if (c == '\n') { str += "\\n";  }
+		else if (c == '\r') { str += "\\r";  }
+		else if (c == '\t') { str += "\\t";  }
+		else if (0 <= c && c < 0x20) {
+			str += "\\u";
+			write_hex_16(static_cast<uint16_t>(c));
+		} else { str += c; }
+
+		str += "'";
+
+		return Text::copy(str.c_str());
+	}
+
+	#define DEFINE_EC(Type)                        \
+		Text ec_to_text(Type value)                \
+		{                                          \
+			auto str = std::to_string(value);      \
+			return Text::copy(str.c_str());      \
+		}
+
+	DEFINE_EC(int)
+	DEFINE_EC(unsigned int)
+	DEFINE_EC(long)
+	DEFINE_EC(unsigned long)
+	DEFINE_EC(long long)
+	DEFINE_EC(unsigned long long)
+	DEFINE_EC(float)
+	DEFINE_EC(double)
+	DEFINE_EC(long double)
+
+	#undef DEFINE_EC
+
+	Text ec_to_text(EcHandle ec_handle)
+	{
+		Text parent_ec = get_error_context_for(ec_handle);
+		return textprintf("\n%s", parent_ec.c_str());
+	}
+
+	// ----------------------------------------------------------------------------
+
+} // namespace loguru
+
+// ----------------------------------------------------------------------------
+// .dP"Y8 88  dP""b8 88b 88    db    88     .dP"Y8
+// `Ybo." 88 dP   `" 88Yb88   dPYb   88     `Ybo."
+// o.`Y8b 88 Yb  "88 88 Y88  dP__Yb  88  .o o.`Y8b
+// 8bodP' 88  YboodP 88  Y8 dP""""Yb 88ood8 8bodP'
+// ----------------------------------------------------------------------------
+
+#ifdef _WIN32
+namespace loguru {
+	void install_signal_handlers()
+	{
+		#if defined(_MSC_VER)
+		#pragma message ( "No signal handlers on Win32" )
+		#else
+		#warning "No signal handlers on Win32"
+		#endif
+	}
+} // namespace loguru
+
+#else // _WIN32
+
+namespace loguru
+{
+	struct Signal
+	{
+		int         number;
+		const char* name;
+	};
+	const Signal ALL_SIGNALS[] = {
+#if LOGURU_CATCH_SIGABRT
+		{ SIGABRT, "SIGABRT" },
+#endif
+		{ SIGBUS,  "SIGBUS"  },
+		{ SIGFPE,  "SIGFPE"  },
+		{ SIGILL,  "SIGILL"  },
+		{ SIGINT,  "SIGINT"  },
+		{ SIGSEGV, "SIGSEGV" },
+		{ SIGTERM, "SIGTERM" },
+	};
+
+	void write_to_stderr(const char* data, size_t size)
+	{
+		auto result = write(STDERR_FILENO, data, size);
+		(void)result; // Ignore errors.
+	}
+
+	void write_to_stderr(const char* data)
+	{
+		write_to_stderr(data, strlen(data));
+	}
+
+	void call_default_signal_handler(int signal_number)
+	{
+		struct sigaction sig_action;
+		memset(&sig_action, 0, sizeof(sig_action));
+		sigemptyset(&sig_action.sa_mask);
+		sig_action.sa_handler = SIG_DFL;
+		sigaction(signal_number, &sig_action, NULL);
+		kill(getpid(), signal_number);
+	}
+
+	void signal_handler(int signal_number, siginfo_t*, void*)
+	{
+		const char* signal_name = "UNKNOWN SIGNAL";
+
+		for (const auto& s : ALL_SIGNALS) {
+			if (s.number == signal_number) {
+				signal_name = s.name;
+				break;
+			}
+		}
+
+		// --------------------------------------------------------------------
+		/* There are few things that are safe to do in a signal handler,
+		   but writing to stderr is one of them.
+		   So we first print out what happened to stderr so we're sure that gets out,
+		   then we do the unsafe things, like logging the stack trace.
+		*/
+
+		if (g_colorlogtostderr && s_terminal_has_color) {
+			write_to_stderr(terminal_reset());
+			write_to_stderr(terminal_bold());
+			write_to_stderr(terminal_light_red());
+		}
+		write_to_stderr("\n");
+		write_to_stderr("Loguru caught a signal: ");
+		write_to_stderr(signal_name);
+		write_to_stderr("\n");
+		if (g_colorlogtostderr && s_terminal_has_color) {
+			write_to_stderr(terminal_reset());
+		}
+
+		// --------------------------------------------------------------------
+
+#if LOGURU_UNSAFE_SIGNAL_HANDLER
+		// --------------------------------------------------------------------
+		/* Now we do unsafe things. This can for example lead to deadlocks if
+		   the signal was triggered from the system's memory management functions
+		   and the code below tries to do allocations.
+		*/
+
+		std::unique_lock<LogMutex> lock(s_mutex, std::defer_lock);
+		if (emergency_drain(lock)) {
+			flush();
+			const auto timestamp = now_timestamp(true);
+			char preamble_buff[128];
+			print_preamble(preamble_buff, sizeof(preamble_buff), timestamp, Verbosity_FATAL, "", 0);
+			auto message = Message{Verbosity_FATAL, "", 0, preamble_buff, "", "Signal: ", signal_name, timestamp.epoch_ns, 1, ""};
+			try {
+				log_message(1, message, false, false);
+			} catch (...) {
+				// This can happed due to s_fatal_handler.
+				write_to_stderr("Exception caught and ignored by Loguru signal handler.\n");
+			}
+			flush();
+		} else {
+			write_to_stderr("Loguru could not get its lock in time; skipping the stack trace.\n");
+		}
+
+		// --------------------------------------------------------------------
+#endif // LOGURU_UNSAFE_SIGNAL_HANDLER
+
+		call_default_signal_handler(signal_number);
+	}
+
+	void install_signal_handlers()
+	{
+		struct sigaction sig_action;
+		memset(&sig_action, 0, sizeof(sig_action));
+		sigemptyset(&sig_action.sa_mask);
+		sig_action.sa_flags |= SA_SIGINFO;
+		sig_action.sa_sigaction = &signal_handler;
+		for (const auto& s : ALL_SIGNALS) {
+			CHECK_F(sigaction(s.number, &sig_action, NULL) != -1,
+				"Failed to install handler for %s", s.name);
+		}
+	}
+} // namespace loguru
+
+#endif // _WIN32
+
@@ -51,7 +51,8 @@ Website: www.ilikebigbits.com
 
 # Compiling
 	Just include <loguru.hpp> where you want to use Loguru.
-	Then, in one .cpp file:
+	Then compile loguru.cpp once, or link with the `loguru` target from CMakeLists.txt.
+	Alternatively, in one .cpp file:
 		#define LOGURU_IMPLEMENTATION 1
 		#include <loguru.hpp>
 	Make sure you compile with -std=c++11 -lstdc++ -lpthread -ldl
@@ -149,6 +150,14 @@ Website: www.ilikebigbits.com
 		Such a scheme is useful if you have a daemon program that moves the log file every 24 hours and expects new file to be created.
 		Feature by scinart (https://github.com/emilk/loguru/pull/23).
 
+	LOGURU_USE_FILE_NAME (default 0):
+		Make the logging macros pass only the file name (foo.cpp) instead of the whole __FILE__ path.
+		The file name is found at compile time (with __FILE_NAME__ where the compiler has it),
+		so the preamble needs no per-message path stripping, and with __FILE_NAME__
+		the full paths no longer end up in the binary.
+		Message::filename and add_filter file patterns then only see the file name.
+		Set it for loguru.cpp too (the CMake option does), or the preamble still strips each path.
+
 	You can also configure:
 	loguru::g_flush_interval_ms:
 		If set to zero Loguru will flush on every line (unbuffered mode).
@@ -180,19 +189,69 @@ Website: www.ilikebigbits.com
 #ifndef LOGURU_SCOPE_TEXT_SIZE
 	// Maximum length of text that can be printed by a LOG_SCOPE.
 	// This should be long enough to get most things, but short enough not to clutter the stack.
+	// Sets the size of LogScopeRAII: loguru.cpp and all its users must agree on it (the CMake target exports it).
 	#define LOGURU_SCOPE_TEXT_SIZE 196
 #endif
 
+#ifndef LOGURU_TEXT_INLINE_SIZE
+	// loguru::Text keeps strings shorter than this inline, without touching the heap.
+	// Sets the size of Text: loguru.cpp and all its users must agree on it (the CMake target exports it).
+	#define LOGURU_TEXT_INLINE_SIZE 48
+#endif
+
+#ifndef LOGURU_SCRATCH_SIZE
+	// Each thread formats its log messages in a scratch buffer of this many bytes.
+	// Longer messages are formatted on the heap.
+	#define LOGURU_SCRATCH_SIZE 2048
+#endif
+
 #ifndef LOGURU_FILENAME_WIDTH
 	// Width of the column containing the file name
 	#define LOGURU_FILENAME_WIDTH 23
 #endif
 
 #ifndef LOGURU_THREADNAME_WIDTH
-	// Width of the column containing the thread name
+	// Width of the column containing the thread name.
+	// Sets the size of ThreadAliasScope: loguru.cpp and all its users must agree on it (the CMake target exports it).
 	#define LOGURU_THREADNAME_WIDTH 16
 #endif
 
+#ifndef LOGURU_SOCKET_BATCH_SIZE
+	// A socket sink sends its pending records when they reach this many bytes (or on flush).
+	#define LOGURU_SOCKET_BATCH_SIZE 16384
+#endif
+
+#ifndef LOGURU_SOCKET_SPILL_SIZE
+	// A socket sink holds at most this many bytes while the receiver is stalled. Excess records are dropped.
+	#define LOGURU_SOCKET_SPILL_SIZE (1024 * 1024)
+#endif
+
+#ifndef LOGURU_SOCKET_RETRY_MS
+	// After a failed connect, a socket sink waits this long before trying to reconnect.
+	#define LOGURU_SOCKET_RETRY_MS 1000
+#endif
+
+#ifndef LOGURU_SHARED_WRITE_SIZE
+	// Largest single write to a file opened with FileMode AppendShared. Keep it at or below PIPE_BUF.
+	#define LOGURU_SHARED_WRITE_SIZE 4096
+#endif
+
+#ifndef LOGURU_ASYNC_SHARD_SIZE
+	// With start_async, each CPU gets two buffers of this many bytes for pending records.
+	#define LOGURU_ASYNC_SHARD_SIZE (256 * 1024)
+#endif
+
+#ifndef LOGURU_LOG_BUFFER_SIZE
+	// Most bytes of messages a LOG_BUFFER_SCOPE holds back. Later messages are dropped (and counted).
+	#define LOGURU_LOG_BUFFER_SIZE (1024 * 1024)
+#endif
+
+#ifndef LOGURU_EMERGENCY_DRAIN_MS
+	// On FATAL, CHECK failures and signals, pending async records are written out before we die.
+	// This is how long to wait for a lock held by another (perhaps stuck) thread before giving up on it.
+	#define LOGURU_EMERGENCY_DRAIN_MS 200
+#endif
+
 #ifndef LOGURU_CATCH_SIGABRT
 	// Should Loguru catch SIGABRT to print stack trace etc?
 	#define LOGURU_CATCH_SIGABRT 1
@@ -232,6 +291,10 @@ Website: www.ilikebigbits.com
 	#define LOGURU_WITH_FILEABS 0
 #endif
 
+#ifndef LOGURU_USE_FILE_NAME
+	#define LOGURU_USE_FILE_NAME 0
+#endif
+
 // --------------------------------------------------------------------
 // Utility macros
 
@@ -264,6 +327,48 @@ Website: www.ilikebigbits.com
 #define LOGURU_NORETURN __attribute__((noreturn))
 #endif
 
+// Used to move the failure paths of CHECK macros out of line, away from the hot code.
+#if defined(_MSC_VER)
+#define LOGURU_COLD __declspec(noinline)
+#else
+#define LOGURU_COLD __attribute__((cold, noinline))
+#endif
+
+// Thread-local storage for plain data the logging macros read inline.
+// Unlike thread_local, other translation units reach it without an initialization wrapper call.
+#if defined(_MSC_VER)
+#define LOGURU_THREAD_LOCAL __declspec(thread)
+#elif defined(__GNUC__) || defined(__clang__)
+#define LOGURU_THREAD_LOCAL __thread
+#else
+#define LOGURU_THREAD_LOCAL thread_local
+#endif
+
+namespace loguru
+{
+	// The offset of the file name in a path: file_name_offset("src/foo.cpp") == 4.
+	// Recursive, to be a C++11 constexpr.
+	constexpr unsigned file_name_offset(const char* path, unsigned i = 0, unsigned last = 0)
+	{
+		return path[i] == '\0' ? last
+			 : file_name_offset(path, i + 1, (path[i] == '/' || path[i] == '\\') ? i + 1 : last);
+	}
+
+	// Forces evaluation at compile time.
+	template<unsigned N> struct FileNameOffset { static const unsigned value = N; };
+} // namespace loguru
+
+// The file passed by all logging macros. See LOGURU_USE_FILE_NAME.
+#if LOGURU_USE_FILE_NAME
+	#if defined(__FILE_NAME__)
+		#define LOGURU_FILE __FILE_NAME__
+	#else
+		#define LOGURU_FILE (__FILE__ + loguru::FileNameOffset<loguru::file_name_offset(__FILE__)>::value)
+	#endif
+#else
+	#define LOGURU_FILE __FILE__
+#endif
+
 #if defined(_MSC_VER)
 #define LOGURU_PREDICT_FALSE(x) (x)
 #define LOGURU_PREDICT_TRUE(x)  (x)
@@ -285,32 +390,35 @@ Website: www.ilikebigbits.com
 namespace loguru
 {
 	// Simple RAII ownership of a char*.
+	// Short strings are kept in an inline buffer instead, and so never touch the heap.
 	class Text
 	{
 	public:
+		// Takes ownership of a malloc:ed string.
 		explicit Text(char* owned_str) : _str(owned_str) {}
 		~Text();
-		Text(Text&& t)
-		{
-			_str = t._str;
-			t._str = nullptr;
-		}
+		Text(Text&& t);
 		Text(Text& t) = delete;
 		Text& operator=(Text& t) = delete;
 		void operator=(Text&& t) = delete;
 
+		// Copies str, into the inline buffer if it fits.
+		static Text copy(const char* str);
+
 		const char* c_str() const { return _str; }
 		bool empty() const { return _str == nullptr || *_str == '\0'; }
 
-		char* release()
-		{
-			auto result = _str;
-			_str = nullptr;
-			return result;
-		}
+		// Returns a malloc:ed string (copied if it was not on the heap) that the caller must free.
+		char* release();
 
 	private:
+		friend struct TextBuilder;
+
+		Text() : _str(_inline) { _inline[0] = '\0'; }
+
 		char* _str;
+		bool* _scratch_in_use = nullptr; // Set if _str is borrowed from a per-thread scratch buffer.
+		char  _inline[LOGURU_TEXT_INLINE_SIZE];
 	};
 
 	// Like printf, but returns the formated text.
@@ -369,21 +477,32 @@ namespace loguru
 		const char* indentation; // Just a bunch of spacing.
 		const char* prefix;      // Assertion failure info goes here (or "").
 		const char* message;     // User message goes here.
+		long long   timestamp_ns; // Nanoseconds since epoch, from the clock chosen with set_clock_mode.
+		unsigned    sample_rate; // 1, or N if this message was sampled 1-in-N (so it stands for about N messages).
+		const char* context;     // LOG_CONTEXT tags, e.g. "[req=42 tenant=\"acme\"] ", or "". Goes between indentation and prefix.
 	};
 
 	/* Everything with a verbosity equal or greater than g_stderr_verbosity will be
 	written to stderr. You can set this in code or via the -v argument.
 	Set to logurur::Verbosity_OFF to write nothing to stderr.
 	Default is 0, i.e. only log ERROR, WARNING and INFO are written to stderr.
+	While watch_verbosity_config may change it from another thread, use stderr_verbosity()
+	and set_stderr_verbosity() instead.
 	*/
 	extern Verbosity g_stderr_verbosity;
 	extern bool      g_colorlogtostderr; // True by default.
 	extern unsigned  g_flush_interval_ms; // 0 (unbuffered) by default.
 
+	// Read and write g_stderr_verbosity atomically (relaxed).
+	Verbosity stderr_verbosity();
+	void set_stderr_verbosity(Verbosity verbosity);
+
 	// May not throw!
 	typedef void (*log_handler_t)(void* user_data, const Message& message);
 	typedef void (*close_handler_t)(void* user_data);
 	typedef void (*flush_handler_t)(void* user_data);
+	// The messages, and the strings they point to, are only valid during the call.
+	typedef void (*batch_handler_t)(void* user_data, const Message* messages, unsigned num_messages);
 
 	// May throw if that's how you'd like to handle your errors.
 	typedef void (*fatal_handler_t)(const Message& message);
@@ -443,6 +562,69 @@ namespace loguru
 	// Writes date and time with millisecond precision, e.g. "20151017_161503.123"
 	void write_date_time(char* buff, unsigned buff_size);
 
+	enum ClockMode
+	{
+		// std::chrono::system_clock for date/time and steady_clock for uptime and scopes (default).
+		Clock_System,
+
+		// CLOCK_REALTIME_COARSE: a single cheap read per message, but only tick resolution (1-4 ms).
+		// Uptime is derived from it too, so it jumps if the wall clock is stepped.
+		// Falls back to Clock_System where unavailable.
+		Clock_Coarse,
+
+		// Invariant TSC (x86), calibrated against CLOCK_REALTIME when selected and re-synced every second.
+		// A few ns per read. Falls back to Clock_Coarse if the CPU has no invariant TSC.
+		Clock_TSC,
+	};
+
+	// Select the clock used for timestamps, the preamble and LOG_SCOPE timings. Returns the mode actually used.
+	ClockMode set_clock_mode(ClockMode mode);
+
+	// Nanoseconds since epoch, read from the selected clock. Same as Message::timestamp_ns.
+	long long timestamp_ns();
+
+	/*  Choose which fields go into the preamble of each log line, and in what order.
+		The pattern is compiled once, so fields you leave out cost nothing.
+			%D   date, e.g. 2017-08-08
+			%T   time, e.g. 16:15:03
+			%ms  milliseconds, e.g. 123
+			%up  uptime in seconds, e.g. "   1.234"
+			%t   thread name or id, padded to LOGURU_THREADNAME_WIDTH
+			%f   file, right-aligned to LOGURU_FILENAME_WIDTH
+			%l   line, left-aligned to 5 characters
+			%v   verbosity (FATL, ERR, WARN or a number)
+			%ns  nanoseconds since epoch, as a plain number (for machine consumption)
+			%%   a single %
+		Everything else is copied verbatim.
+		The default is "%D %T.%ms (%ups) [%t]%f:%l %v| "
+		Call this before loguru::init and add_file, so the header they write matches.
+		Returns false (and keeps the old pattern) if the pattern has unknown fields.
+	*/
+	bool set_preamble_pattern(const char* pattern);
+
+	// A log line split up by parse_log_line.
+	// The strings point into the parsed line and are not zero-terminated.
+	struct LogLine
+	{
+		long long   timestamp_ns;   // From %ns, else from %D %T.%ms (local time, ms precision), else 0.
+		long long   uptime_ms;      // 0 if the pattern has no %up.
+		const char* thread;         // Without padding.
+		unsigned    thread_length;
+		const char* file;           // Without padding.
+		unsigned    file_length;
+		unsigned    line;
+		Verbosity   verbosity;      // Verbosity_INFO if the pattern has no %v.
+		const char* message;        // The rest of the line, after the preamble.
+		unsigned    message_length;
+	};
+
+	/*  Splits up a line of a log file written with the current preamble pattern.
+		length should not include the newline.
+		Returns false if the line does not start with a preamble, e.g. the following
+		lines of a multi-line message, or the header of a log file.
+	*/
+	bool parse_log_line(const char* line, unsigned length, LogLine* out_line);
+
 	// Helper: thread-safe version strerror
 	Text errno_as_text();
 
@@ -453,7 +635,15 @@ namespace loguru
 	*/
 	void suggest_log_path(const char* prefix, char* buff, unsigned buff_size);
 
-	enum FileMode { Truncate, Append };
+	/*  AppendShared is for many processes logging to the same file.
+		The file is opened with O_APPEND and written with one write() per batch of
+		complete records (at most LOGURU_SHARED_WRITE_SIZE bytes), so lines never interleave.
+		A record bigger than that is split into pieces written one by one. Each piece is
+		"[pid.serial k/n length] " followed by length bytes of the record and a newline
+		(the newline ending the record itself is left out).
+		Not supported on Windows, where it is the same as Append.
+	*/
+	enum FileMode { Truncate, Append, AppendShared };
 
 	/*  Will log to a file at the given path.
 		Any logging message with a verbosity lower or equal to
@@ -461,8 +651,41 @@ namespace loguru
 		The function will create all directories in 'path' if needed.
 		If path starts with a ~, it will be replaced with loguru::home_dir()
 		To stop the file logging, just call loguru::remove_callback(path) with the same path.
+
+		If index_interval is non-zero, a sparse index of the log is also written to path + ".idx".
+		It gets an entry (timestamp, byte offset) for the first line after every index_interval bytes,
+		or after a second has passed, whichever comes first. 64 KiB is a good choice.
+		Use find_in_log (or the loguru_seek tool) to jump to a time range in the log.
+		With LOGURU_WITH_FILEABS the index is only valid until the file is first reopened.
+		There is no index for AppendShared files.
+	*/
+	bool add_file(const char* path, FileMode mode, Verbosity verbosity, unsigned index_interval = 0);
+
+	/*  Uses the index next to a log written with add_file(..., index_interval) to find
+		the messages from begin_ns up to end_ns (nanoseconds since epoch, like Message::timestamp_ns).
+		On success they are within bytes [*begin_offset, *end_offset) of the log,
+		where an *end_offset of -1 means the end of the file.
+		The range is widened to the nearest index entries, so it includes some messages outside it.
+		Returns false if there is no readable index.
 	*/
-	bool add_file(const char* path, FileMode mode, Verbosity verbosity);
+	bool find_in_log(const char* log_path, long long begin_ns, long long end_ns,
+	                 long long* begin_offset, long long* end_offset);
+
+	enum SocketProtocol { Plain, Journald };
+
+	/*  Will log to a local AF_UNIX socket at the given path, e.g. a log shipping agent.
+		Both datagram and stream sockets are supported (detected on connect).
+		Plain sends the same lines as a log file would contain.
+		Journald speaks the systemd-journald native protocol (datagram only),
+		e.g. loguru::add_socket("/run/systemd/journal/socket", loguru::Journald, loguru::Verbosity_INFO);
+		Records are batched and sent with non-blocking calls, so a stalled receiver never blocks
+		the logging thread. While stalled, up to LOGURU_SOCKET_SPILL_SIZE bytes are kept.
+		After that records are dropped, and the number of dropped records is reported once the
+		receiver catches up. If the receiver goes away, reconnects are tried at most once
+		every LOGURU_SOCKET_RETRY_MS. In buffered mode (g_flush_interval_ms > 0) each send carries many records.
+		To stop the socket logging, just call loguru::remove_callback(path) with the same path.
+	*/
+	bool add_socket(const char* path, SocketProtocol protocol, Verbosity verbosity);
 
 	/*  Will be called right before abort().
 		You can for instance use this to print custom error messages, or throw an exception.
@@ -478,14 +701,212 @@ namespace loguru
 					  close_handler_t on_close = nullptr,
 					  flush_handler_t on_flush = nullptr);
 
+	/*  Like add_callback, but the messages are collected and handed over many at a time,
+		which amortizes the per-call and locking overhead for sinks such as metrics exporters.
+		A batch is handed over once it holds max_batch_size messages, once its oldest message
+		is max_latency_ms old (checked on logging and by a background flusher), on flush() and
+		on remove_callback. Batches keep the log order, and may be smaller than max_batch_size.
+		on_flush is called after each batch.
+	*/
+	void add_batch_callback(const char* id, batch_handler_t callback, void* user_data,
+							Verbosity verbosity,
+							unsigned max_batch_size = 256,
+							unsigned max_latency_ms = 100,
+							close_handler_t on_close = nullptr,
+							flush_handler_t on_flush = nullptr);
+
 	// Returns true iff the callback was found (and removed).
 	bool remove_callback(const char* id);
 
+	/*  Routing rules for a single file or callback.
+		A sink without rules gets every message within its verbosity.
+		A sink with rules only gets those messages that also match at least one of its rules.
+		All fields that are set in a rule must match. Example:
+
+			// Only WARNING:s and worse from net/*.cpp:
+			loguru::add_file("net_warnings.log", loguru::Truncate, loguru::Verbosity_WARNING);
+			loguru::FilterRule net;
+			net.file = "net/*.cpp";
+			loguru::add_filter("net_warnings.log", net);
+
+		The file part is decided once per call site (file + line) and then cached,
+		so routing on file costs a bit test per message. Thread and message rules
+		are checked per message, but only for the sinks whose file part matched.
+	*/
+	struct FilterRule
+	{
+		const char* file    = nullptr; // Glob (* and ?) matched against the end of the source path, e.g. "net/*.cpp".
+		const char* thread  = nullptr; // Glob matched against the thread name, e.g. "worker *".
+		const char* message = nullptr; // Regular expression (ECMAScript) searched for in the message.
+	};
+
+	// Returns false if there is no file or callback with the given id, or the regular expression is invalid.
+	bool add_filter(const char* id, const FilterRule& rule);
+
+	// Remove all rules from a file or callback, so it gets everything within its verbosity again.
+	bool clear_filters(const char* id);
+
 	// Shut down all file logging and any other callback hooks installed.
 	void remove_all_callbacks();
 
-	// Returns the maximum of g_stderr_verbosity and all file/custom outputs.
-	Verbosity current_verbosity_cutoff();
+	// Internal: the result of current_verbosity_cutoff on this thread, valid while nothing it depends on has changed.
+	struct VerbosityCutoffCache
+	{
+		unsigned  generation;       // Of g_verbosity_generation. 0 (never current) until computed.
+		Verbosity stderr_verbosity; // g_stderr_verbosity, which may be assigned directly.
+		Verbosity cutoff;
+	};
+	extern LOGURU_THREAD_LOCAL VerbosityCutoffCache g_verbosity_cutoff_cache;
+	extern unsigned g_verbosity_generation; // Internal: bumped whenever an output or module verbosity changes.
+
+	// Internal: recomputes and caches the cutoff of this thread.
+	Verbosity refresh_verbosity_cutoff();
+
+	// Returns the maximum of g_stderr_verbosity, all file/custom outputs and what they accept of a raised thread.
+	// Inline, and cached per thread: no call and no atomic operation unless something changed.
+	inline Verbosity current_verbosity_cutoff()
+	{
+		const VerbosityCutoffCache& cache = g_verbosity_cutoff_cache;
+	#if defined(__GNUC__) || defined(__clang__)
+		const unsigned generation = __atomic_load_n(&g_verbosity_generation, __ATOMIC_RELAXED);
+		const Verbosity stderr_cutoff = __atomic_load_n(&g_stderr_verbosity, __ATOMIC_RELAXED);
+	#else
+		const unsigned generation = *static_cast<volatile unsigned*>(&g_verbosity_generation);
+		const Verbosity stderr_cutoff = *static_cast<volatile Verbosity*>(&g_stderr_verbosity);
+	#endif
+		return cache.generation == generation && cache.stderr_verbosity == stderr_cutoff ? cache.cutoff
+																						  : refresh_verbosity_cutoff();
+	}
+
+	// Change the verbosity of a file or callback. Returns false if there is no such id.
+	bool set_callback_verbosity(const char* id, Verbosity verbosity);
+
+	/*  Let a file or callback also take the messages of a thread raised by ScopedVerbosity
+		(or LOG_BUFFER_SCOPE) up to the given verbosity, on top of its own verbosity.
+		Verbosity_OFF, the default, means it only ever gets what is within its own verbosity.
+		Returns false if there is no such id. */
+	bool set_callback_raised_verbosity(const char* id, Verbosity verbosity);
+
+	/*  Like g_stderr_verbosity, but only for messages from source files matching the given glob,
+		e.g. set_module_verbosity("net/*.cpp", 9). The glob is matched like FilterRule::file.
+		The module verbosity is resolved once per call site and then cached. */
+	void set_module_verbosity(const char* file_glob, Verbosity verbosity);
+	void clear_module_verbosities();
+
+	/*  Raises the verbosity of this thread for the scope, e.g. to debug one request among thousands:
+
+			void handle(const Request& request)
+			{
+				loguru::ScopedVerbosity debug(request.debug ? 9 : loguru::Verbosity_OFF);
+				VLOG_F(9, "Parsed %s", ...); // Written to debug.log, for this request only.
+			}
+
+			loguru::add_file("debug.log", loguru::Append, loguru::Verbosity_INFO);
+			loguru::set_callback_raised_verbosity("debug.log", 9);
+
+		While raised, VLOG_F etc let through messages up to the given verbosity, as far as some
+		file or callback accepts them (see set_callback_raised_verbosity). Those get the raised
+		messages of this thread; the other threads still only get their own verbosity.
+		stderr (g_stderr_verbosity or a module verbosity) is never raised.
+		The extra cost of the cutoff check is one thread-local read.
+		Scopes nest, and an inner scope never lowers the verbosity of an outer one.
+		With start_async, raised messages are buffered like any other, so they keep their order.
+
+		To carry the verbosity into tasks spawned from the scope, pass thread_verbosity() along:
+
+			const auto verbosity = loguru::thread_verbosity();
+			pool.submit([=]{
+				loguru::ScopedVerbosity inherited(verbosity);
+				...
+			});
+	*/
+	class ScopedVerbosity
+	{
+	public:
+		explicit ScopedVerbosity(Verbosity verbosity);
+		~ScopedVerbosity();
+
+	private:
+		ScopedVerbosity(const ScopedVerbosity&) = delete;
+		ScopedVerbosity& operator=(const ScopedVerbosity&) = delete;
+
+		Verbosity _previous;
+	};
+
+	// The verbosity set by ScopedVerbosity on this thread, or Verbosity_OFF if none.
+	Verbosity thread_verbosity();
+
+	/*  Tail-based logging: hold back the verbose messages of this thread during the scope,
+		and only write them out if something goes wrong:
+
+			void handle(const Request& request)
+			{
+				LOG_BUFFER_SCOPE(9);
+				VLOG_F(5, "Parsed %s", ...);  // Held back.
+				LOG_F(INFO, "Handling");      // Written as usual.
+				if (!ok) {
+					LOG_F(WARNING, "Failed"); // Writes out the held back messages first, then this.
+				}
+			}
+
+		The scope raises the verbosity of the thread like ScopedVerbosity(max_verbosity),
+		and copies messages more verbose than hold_above (INFO by default, at least WARNING)
+		into a thread-local buffer instead of the outputs, e.g. LOG_BUFFER_SCOPE(9, 1) also writes
+		out verbosity 1 directly. Each copy keeps the indentation it was logged with.
+		On the first WARNING, ERROR or FATAL (including a failed CHECK) in the scope, the held back
+		messages are written out in order, with their original timestamps, and the rest of the scope
+		is written directly. Otherwise they are dropped at the end of the scope, which costs nothing
+		more than the copies: the buffer memory is reused by the next scope on the thread.
+		As with ScopedVerbosity, the held back messages only go to the files and callbacks that
+		accept them, by their own verbosity or by set_callback_raised_verbosity.
+		At most LOGURU_LOG_BUFFER_SIZE bytes are held back; the number of messages dropped beyond that is reported.
+		A LOG_BUFFER_SCOPE within another one only raises the verbosity; its hold_above is ignored.
+	*/
+	#define LOG_BUFFER_SCOPE(...) \
+		const loguru::LogBufferScope LOGURU_ANONYMOUS_VARIABLE(log_buffer_scope_)(__VA_ARGS__)
+
+	// Helper class for LOG_BUFFER_SCOPE
+	class LogBufferScope
+	{
+	public:
+		explicit LogBufferScope(Verbosity max_verbosity, Verbosity hold_above = Verbosity_INFO);
+		~LogBufferScope();
+
+	private:
+		LogBufferScope(const LogBufferScope&) = delete;
+		LogBufferScope& operator=(const LogBufferScope&) = delete;
+
+		ScopedVerbosity _verbosity;
+		bool            _owner; // False within another LogBufferScope, which does the buffering.
+	};
+
+	/*  Reconfigure verbosity at run-time from a small text file, e.g.:
+
+			# Comments start with #
+			stderr                   = WARNING
+			sink everything.log      = 9
+			module net/*.cpp         = 5
+
+		"sink" takes the id given to add_file/add_callback.
+		Verbosities are integers or INFO, WARNING, ERROR, FATAL, OFF.
+		The whole file is applied at once, or not at all if it has errors.
+		Module verbosities are replaced by the ones in the file. Sinks not mentioned keep their verbosity.
+		Returns false on errors.
+	*/
+	bool load_verbosity_config(const char* path);
+
+	/*  Start a background thread which calls load_verbosity_config(path) whenever the file changes
+		(checked every poll_interval_ms).
+		Use this to turn on debug logging on a running process without restarting it.
+		A poll_interval_ms of 0 is treated as 1.
+		With reload_on_sighup, the file is also reloaded soon after the process receives SIGHUP.
+		This replaces any SIGHUP handler of the process (it is not called) until unwatch_verbosity_config,
+		so leave it off if the program uses SIGHUP for anything else. Ignored on Windows. */
+	void watch_verbosity_config(const char* path, unsigned poll_interval_ms = 1000, bool reload_on_sighup = false);
+
+	/*  Stop the thread started by watch_verbosity_config and restore any SIGHUP handler it replaced.
+		The current verbosities are kept. Called by shutdown(). */
+	void unwatch_verbosity_config();
 
 #if LOGURU_USE_FMTLIB
 	// Actual logging function. Use the LOG macro instead of calling this directly.
@@ -503,6 +924,27 @@ namespace loguru
 	void raw_log(Verbosity verbosity, const char* file, unsigned line, LOGURU_FORMAT_STRING_TYPE format, ...) LOGURU_PRINTF_LIKE(4, 5);
 #endif // !LOGURU_USE_FMTLIB
 
+	/*  Sampling of verbose logs.
+		With set_sample_rate(9, 1000) only about one in a thousand LOG_F(9, ...) is written.
+		Use LOG_SAMPLED_F(verbosity_name, one_in_n, ...) to sample a single call site instead.
+		Sampled messages are prefixed with "[1/N] " and have Message::sample_rate set to N,
+		so that they can be scaled up again downstream.
+		The decision is made by a thread-local xorshift generator, before any formatting.
+		Only verbosity 1-9 can be sampled: INFO, WARNING etc are always written. */
+	void set_sample_rate(Verbosity verbosity, unsigned one_in_n);
+
+	// Returns true with probability 1/one_in_n.
+	bool sample(unsigned one_in_n);
+
+#if LOGURU_USE_FMTLIB
+	// Use the LOG_SAMPLED_F macro instead of calling this directly.
+	void log_sampled(unsigned one_in_n, Verbosity verbosity, const char* file, unsigned line, LOGURU_FORMAT_STRING_TYPE format, fmt::ArgList args);
+	FMT_VARIADIC(void, log_sampled, unsigned, Verbosity, const char*, unsigned, LOGURU_FORMAT_STRING_TYPE)
+#else
+	// Use the LOG_SAMPLED_F macro instead of calling this directly.
+	void log_sampled(unsigned one_in_n, Verbosity verbosity, const char* file, unsigned line, LOGURU_FORMAT_STRING_TYPE format, ...) LOGURU_PRINTF_LIKE(5, 6);
+#endif
+
 	// Helper class for LOG_SCOPE_F
 	class LogScopeRAII
 	{
@@ -528,14 +970,49 @@ namespace loguru
 
 	// Marked as 'noreturn' for the benefit of the static analyzer and optimizer.
 	// stack_trace_skip is the number of extrace stack frames to skip above log_and_abort.
-	LOGURU_NORETURN void log_and_abort(int stack_trace_skip, const char* expr, const char* file, unsigned line, LOGURU_FORMAT_STRING_TYPE format, ...) LOGURU_PRINTF_LIKE(5, 6);
-	LOGURU_NORETURN void log_and_abort(int stack_trace_skip, const char* expr, const char* file, unsigned line);
+	LOGURU_NORETURN LOGURU_COLD void log_and_abort(int stack_trace_skip, const char* expr, const char* file, unsigned line, LOGURU_FORMAT_STRING_TYPE format, ...) LOGURU_PRINTF_LIKE(5, 6);
+	LOGURU_NORETURN LOGURU_COLD void log_and_abort(int stack_trace_skip, const char* expr, const char* file, unsigned line);
 
 	// Flush output to stderr and files.
 	// If g_flush_interval_ms is set to non-zero, this will be called automatically this often.
 	// If not set, you do not need to call this at al.
+	// With async logging this first writes out all pending records.
 	void flush();
 
+	/*  Asynchronous logging.
+		After start_async, LOG_F etc only format the message and copy it into a buffer.
+		A background thread writes the buffered records to stderr and all callbacks
+		at least every max_latency_ms, in timestamp order.
+		There is one buffer per CPU (not per thread), so memory is bounded by the core count
+		no matter how many threads log. A thread that finds its buffer full writes out all
+		pending records itself. FATAL messages, LOG_SCOPE_F and flush() also write out
+		everything pending first, so nothing is lost or reordered around a crash.
+		On FATAL (including failed CHECKs) and, with LOGURU_UNSAFE_SIGNAL_HANDLER, on signals,
+		async logging is switched off for good and the pending records of every thread are written out,
+		waiting at most LOGURU_EMERGENCY_DRAIN_MS for threads holding the log lock.
+		If the lock stays taken, the records go straight to stderr instead. */
+	void start_async(unsigned shard_size = LOGURU_ASYNC_SHARD_SIZE, unsigned max_latency_ms = 10,
+					 unsigned memory_flags = 0);
+
+	// Flags for start_async, controlling how the shard buffers are allocated (all at once, up front).
+	// The total footprint is logged when async logging starts.
+	enum AsyncMemory
+	{
+		AsyncMemory_Populate  = 1, // Fault in every page up front, so a burst never takes a page fault.
+		AsyncMemory_HugePages = 2, // Use explicit huge pages if available, else transparent huge pages.
+		AsyncMemory_Lock      = 4, // mlock the buffers, so they are never swapped out.
+	};
+
+	// Write out everything pending and go back to logging synchronously.
+	void stop_async();
+
+	/*  With async logging, records at or below this verbosity skip the buffers:
+		everything pending is written out first (so the order is kept),
+		then the record is written and all sinks are flushed right away.
+		Use e.g. Verbosity_WARNING so errors reach the disk before a crash.
+		Default is Verbosity_FATAL. */
+	void set_async_priority_verbosity(Verbosity verbosity);
+
 	template<class T> inline Text format_value(const T&)                    { return textprintf("N/A");     }
 	template<>        inline Text format_value(const char& v)               { return textprintf("%c",   v); }
 	template<>        inline Text format_value(const int& v)                { return textprintf("%d",   v); }
@@ -547,6 +1024,18 @@ namespace loguru
 	template<>        inline Text format_value(const float& v)              { return textprintf("%f",   v); }
 	template<>        inline Text format_value(const double& v)             { return textprintf("%f",   v); }
 
+	// The failure path of CHECK_OP_F, kept out of line so that each call site is just a compare and a branch.
+	template<class T1, class T2, class... Args>
+	LOGURU_NORETURN LOGURU_COLD void check_op_failed(const char* expr, const char* op, const T1& left, const T2& right,
+													 const char* file, unsigned line, const Args&... args)
+	{
+		auto str_left = format_value(left);
+		auto str_right = format_value(right);
+		auto fail_info = textprintf("CHECK FAILED:  %s  (%s %s %s)  ", expr, str_left.c_str(), op, str_right.c_str());
+		auto user_msg = textprintf(args...);
+		log_and_abort(1, fail_info.c_str(), file, line, "%s", user_msg.c_str());
+	}
+
 	/* Thread names can be set for the benefit of readable logs.
 	   If you do not set the thread name, a hex id will be shown instead.
 	   These thread names may or may not be the same as the system thread names,
@@ -564,6 +1053,34 @@ namespace loguru
 	*/
 	void get_thread_name(char* buffer, unsigned long long length, bool right_align_hext_id);
 
+	/*  For the rest of the scope, this thread goes by the given name in the preamble,
+		in thread filters and in get_thread_name. Meant for thread pool tasks:
+
+			pool.submit([=]{
+				LOG_THREAD_ALIAS(task.name);  // e.g. "ingest#1234" instead of "worker-7"
+				...
+			});
+
+		Unlike set_thread_name, this is a small copy into a fixed-size thread-local buffer,
+		with no allocation or system call. The name is cut to LOGURU_THREADNAME_WIDTH characters.
+		Scopes nest: the previous name comes back at the end of the scope. */
+	#define LOG_THREAD_ALIAS(name) \
+		const loguru::ThreadAliasScope LOGURU_ANONYMOUS_VARIABLE(thread_alias_scope_)(name)
+
+	// Helper class for LOG_THREAD_ALIAS
+	class ThreadAliasScope
+	{
+	public:
+		explicit ThreadAliasScope(const char* name);
+		~ThreadAliasScope();
+
+	private:
+		ThreadAliasScope(const ThreadAliasScope&) = delete;
+		ThreadAliasScope& operator=(const ThreadAliasScope&) = delete;
+
+		char _previous[LOGURU_THREADNAME_WIDTH + 1]; // The alias to restore, or "".
+	};
+
 	/* Generates a readable stacktrace as a string.
 	   'skip' specifies how many stack frames to skip.
 	   For instance, the default skip (1) means:
@@ -749,13 +1266,13 @@ namespace loguru
 	#define ERROR_CONTEXT(descr, data)                                             \
 		const loguru::EcEntryData<loguru::make_ec_type<decltype(data)>::type>      \
 			LOGURU_ANONYMOUS_VARIABLE(error_context_scope_)(                       \
-				__FILE__, __LINE__, descr, data,                                   \
+				LOGURU_FILE, __LINE__, descr, data,                                   \
 				static_cast<loguru::EcEntryData<loguru::make_ec_type<decltype(data)>::type>::Printer>(loguru::ec_to_text) ) // For better error messages
 
 /*
 	#define ERROR_CONTEXT(descr, data)                                 \
 		const auto LOGURU_ANONYMOUS_VARIABLE(error_context_scope_)(    \
-			loguru::make_ec_entry_lambda(__FILE__, __LINE__, descr,    \
+			loguru::make_ec_entry_lambda(LOGURU_FILE, __LINE__, descr, \
 				[=](){ return loguru::ec_to_text(data); }))
 */
 
@@ -820,14 +1337,14 @@ namespace loguru
 			{
 				// Called only when needed, i.e. on a crash.
 				std::string str = small_value.as_string(); // Format 'small_value' here somehow.
-				return Text{strdup(str.c_str())};
+				return Text::copy(str.c_str());
 			}
 
 			Text ec_to_text(const MyBigType* big_value)
 			{
 				// Called only when needed, i.e. on a crash.
 				std::string str = big_value->as_string(); // Format 'big_value' here somehow.
-				return Text{strdup(str.c_str())};
+				return Text::copy(str.c_str());
 			}
 		} // namespace loguru
 
@@ -839,6 +1356,39 @@ namespace loguru
 			....
 		}
 	*/
+
+	/*	Tags every message logged by this thread during the scope, e.g.
+
+			void handle(const Request& request)
+			{
+				LOG_CONTEXT("req", request.id);
+				LOG_CONTEXT("tenant", request.tenant.c_str());
+				LOG_F(INFO, "Handling");  // ... main.cpp:12  0| [req=42 tenant="acme"] Handling
+			}
+
+		The value is formatted with ec_to_text (see above) once, when the scope is entered,
+		and the tags are rendered once per scope change, so logging just copies them.
+		Sinks get them as Message::context; get_log_context() returns them without brackets.
+	*/
+	#define LOG_CONTEXT(key, value) \
+		const loguru::LogContextScope LOGURU_ANONYMOUS_VARIABLE(log_context_scope_)(key, loguru::ec_to_text(value))
+
+	// Helper class for LOG_CONTEXT
+	class LogContextScope
+	{
+	public:
+		LogContextScope(const char* key, Text value);
+		~LogContextScope();
+
+	private:
+		LogContextScope(const LogContextScope&) = delete;
+		LogContextScope& operator=(const LogContextScope&) = delete;
+
+		unsigned _previous_size; // Of the tags of this thread, before we added ours.
+	};
+
+	// The LOG_CONTEXT tags of this thread, e.g. "req=42 tenant=\"acme\"", or "".
+	const char* get_log_context();
 } // namespace loguru
 
 // --------------------------------------------------------------------
@@ -847,7 +1397,7 @@ namespace loguru
 // LOG_F(2, "Only logged if verbosity is 2 or higher: %d", some_number);
 #define VLOG_F(verbosity, ...)                                                                     \
 	((verbosity) > loguru::current_verbosity_cutoff()) ? (void)0                                   \
-									  : loguru::log(verbosity, __FILE__, __LINE__, __VA_ARGS__)
+									  : loguru::log(verbosity, LOGURU_FILE, __LINE__, __VA_ARGS__)
 
 // LOG_F(INFO, "Foo: %d", some_number);
 #define LOG_F(verbosity_name, ...) VLOG_F(loguru::Verbosity_ ## verbosity_name, __VA_ARGS__)
@@ -855,20 +1405,29 @@ namespace loguru
 #define VLOG_IF_F(verbosity, cond, ...)                                                            \
 	((verbosity) > loguru::current_verbosity_cutoff() || (cond) == false)                          \
 		? (void)0                                                                                  \
-		: loguru::log(verbosity, __FILE__, __LINE__, __VA_ARGS__)
+		: loguru::log(verbosity, LOGURU_FILE, __LINE__, __VA_ARGS__)
 
 #define LOG_IF_F(verbosity_name, cond, ...)                                                        \
 	VLOG_IF_F(loguru::Verbosity_ ## verbosity_name, cond, __VA_ARGS__)
 
+// LOG_SAMPLED_F(9, 1000, "Only about one in a thousand of these are logged: %d", x);
+#define VLOG_SAMPLED_F(verbosity, one_in_n, ...)                                                   \
+	((verbosity) > loguru::current_verbosity_cutoff() || !loguru::sample(one_in_n))                \
+		? (void)0                                                                                  \
+		: loguru::log_sampled(one_in_n, verbosity, LOGURU_FILE, __LINE__, __VA_ARGS__)
+
+#define LOG_SAMPLED_F(verbosity_name, one_in_n, ...)                                               \
+	VLOG_SAMPLED_F(loguru::Verbosity_ ## verbosity_name, one_in_n, __VA_ARGS__)
+
 #define VLOG_SCOPE_F(verbosity, ...)                                                               \
 	loguru::LogScopeRAII LOGURU_ANONYMOUS_VARIABLE(error_context_RAII_) =                          \
 	((verbosity) > loguru::current_verbosity_cutoff()) ? loguru::LogScopeRAII() :                  \
-	loguru::LogScopeRAII(verbosity, __FILE__, __LINE__, __VA_ARGS__)
+	loguru::LogScopeRAII(verbosity, LOGURU_FILE, __LINE__, __VA_ARGS__)
 
 // Raw logging - no preamble, no indentation. Slightly faster than full logging.
 #define RAW_VLOG_F(verbosity, ...)                                                                 \
 	((verbosity) > loguru::current_verbosity_cutoff()) ? (void)0                                   \
-									  : loguru::raw_log(verbosity, __FILE__, __LINE__, __VA_ARGS__)
+									  : loguru::raw_log(verbosity, LOGURU_FILE, __LINE__, __VA_ARGS__)
 
 #define RAW_LOG_F(verbosity_name, ...) RAW_VLOG_F(loguru::Verbosity_ ## verbosity_name, __VA_ARGS__)
 
@@ -882,13 +1441,13 @@ namespace loguru
 // ABORT_F macro. Usage:  ABORT_F("Cause of error: %s", error_str);
 
 // Message is optional
-#define ABORT_F(...) loguru::log_and_abort(0, "ABORT: ", __FILE__, __LINE__, __VA_ARGS__)
+#define ABORT_F(...) loguru::log_and_abort(0, "ABORT: ", LOGURU_FILE, __LINE__, __VA_ARGS__)
 
 // --------------------------------------------------------------------
 // CHECK_F macros:
 
 #define CHECK_WITH_INFO_F(test, info, ...)                                                         \
-	LOGURU_PREDICT_TRUE((test) == true) ? (void)0 : loguru::log_and_abort(0, "CHECK FAILED:  " info "  ", __FILE__,      \
+	LOGURU_PREDICT_TRUE((test) == true) ? (void)0 : loguru::log_and_abort(0, "CHECK FAILED:  " info "  ", LOGURU_FILE,      \
 													   __LINE__, ##__VA_ARGS__)
 
 /* Checked at runtime too. Will print error, then call fatal_handler (if any), then 'abort'.
@@ -898,6 +1457,7 @@ namespace loguru
 
 #define CHECK_NOTNULL_F(x, ...) CHECK_WITH_INFO_F((x) != nullptr, #x " != nullptr", ##__VA_ARGS__)
 
+// The sizeof is never evaluated: it is only there to have the compiler check the format string.
 #define CHECK_OP_F(expr_left, expr_right, op, ...)                                                 \
 	do                                                                                             \
 	{                                                                                              \
@@ -905,13 +1465,9 @@ namespace loguru
 		auto val_right = expr_right;                                                               \
 		if (! LOGURU_PREDICT_TRUE(val_left op val_right))                                          \
 		{                                                                                          \
-			auto str_left = loguru::format_value(val_left);                                        \
-			auto str_right = loguru::format_value(val_right);                                      \
-			auto fail_info = loguru::textprintf("CHECK FAILED:  %s %s %s  (%s %s %s)  ",            \
-				#expr_left, #op, #expr_right, str_left.c_str(), #op, str_right.c_str());           \
-			auto user_msg = loguru::textprintf(__VA_ARGS__);                                        \
-			loguru::log_and_abort(0, fail_info.c_str(), __FILE__, __LINE__,                        \
-								  "%s", user_msg.c_str());                                         \
+			(void)sizeof(loguru::textprintf(__VA_ARGS__));                                         \
+			loguru::check_op_failed(#expr_left " " #op " " #expr_right, #op, val_left, val_right,  \
+									LOGURU_FILE, __LINE__, ##__VA_ARGS__);                            \
 		}                                                                                          \
 	} while (false)
 
@@ -1007,7 +1563,7 @@ namespace loguru
 */
 
 #include <cstdarg>
-#include <sstream> // Adds about 38 kLoC on clang.
+#include <ostream> // Much lighter than <sstream>.
 #include <string>
 
 namespace loguru
@@ -1018,6 +1574,22 @@ namespace loguru
 	// Like vsprintf, but returns the formated text.
 	std::string vstrprintf(LOGURU_FORMAT_STRING_TYPE format, va_list) LOGURU_PRINTF_LIKE(1, 0);
 
+	// Collects what is streamed into a StreamLogger/AbortLogger.
+	// Used instead of std::ostringstream so that callsites need not include <sstream>.
+	class StreamBuffer : public std::streambuf
+	{
+	public:
+		StreamBuffer() { setp(_buff, _buff + sizeof(_buff)); }
+		std::string& str();
+
+	protected:
+		int_type overflow(int_type ch) override;
+
+	private:
+		char        _buff[128];
+		std::string _str;
+	};
+
 	class StreamLogger
 	{
 	public:
@@ -1039,10 +1611,11 @@ namespace loguru
 		}
 
 	private:
-		Verbosity   _verbosity;
-		const char* _file;
-		unsigned    _line;
-		std::ostringstream _ss;
+		Verbosity    _verbosity;
+		const char*  _file;
+		unsigned     _line;
+		StreamBuffer _buffer;
+		std::ostream _ss{&_buffer};
 	};
 
 	class AbortLogger
@@ -1066,10 +1639,11 @@ namespace loguru
 		}
 
 	private:
-		const char*        _expr;
-		const char*        _file;
-		unsigned           _line;
-		std::ostringstream _ss;
+		const char*  _expr;
+		const char*  _file;
+		unsigned     _line;
+		StreamBuffer _buffer;
+		std::ostream _ss{&_buffer};
 	};
 
 	class Voidify
@@ -1084,14 +1658,22 @@ namespace loguru
 	/*  Helper functions for CHECK_OP_S macro.
 		GLOG trick: The (int, int) specialization works around the issue that the compiler
 		will not instantiate the template version of the function on values of unnamed enum type. */
+	// The failure path of CHECK_OP_S, kept out of line.
+	template <typename T1, typename T2>
+	LOGURU_COLD std::string* check_op_message(const char* expr, const T1& v1, const char* op_str, const T2& v2)
+	{
+		StreamBuffer buffer;
+		std::ostream ss(&buffer);
+		ss << "CHECK FAILED:  " << expr << "  (" << v1 << " " << op_str << " " << v2 << ")  ";
+		return new std::string(buffer.str());
+	}
+
 	#define DEFINE_CHECK_OP_IMPL(name, op)                                                             \
 		template <typename T1, typename T2>                                                            \
 		inline std::string* name(const char* expr, const T1& v1, const char* op_str, const T2& v2)     \
 		{                                                                                              \
 			if (LOGURU_PREDICT_TRUE(v1 op v2)) { return NULL; }                                        \
-			std::ostringstream ss;                                                                     \
-			ss << "CHECK FAILED:  " << expr << "  (" << v1 << " " << op_str << " " << v2 << ")  ";     \
-			return new std::string(ss.str());                                                          \
+			return check_op_message(expr, v1, op_str, v2);                                             \
 		}                                                                                              \
 		inline std::string* name(const char* expr, int v1, const char* op_str, int v2)                 \
 		{                                                                                              \
@@ -1130,7 +1712,7 @@ namespace loguru
 #define VLOG_IF_S(verbosity, cond)                                                                 \
 	((verbosity) > loguru::current_verbosity_cutoff() || (cond) == false)                          \
 		? (void)0                                                                                  \
-		: loguru::Voidify() & loguru::StreamLogger(verbosity, __FILE__, __LINE__)
+		: loguru::Voidify() & loguru::StreamLogger(verbosity, LOGURU_FILE, __LINE__)
 #define LOG_IF_S(verbosity_name, cond) VLOG_IF_S(loguru::Verbosity_ ## verbosity_name, cond)
 #define VLOG_S(verbosity)              VLOG_IF_S(verbosity, true)
 #define LOG_S(verbosity_name)          VLOG_S(loguru::Verbosity_ ## verbosity_name)
@@ -1138,7 +1720,7 @@ namespace loguru
 // -----------------------------------------------
 // ABORT_S macro. Usage:  ABORT_S() << "Causo of error: " << details;
 
-#define ABORT_S() loguru::Voidify() & loguru::AbortLogger("ABORT: ", __FILE__, __LINE__)
+#define ABORT_S() loguru::Voidify() & loguru::AbortLogger("ABORT: ", LOGURU_FILE, __LINE__)
 
 // -----------------------------------------------
 // CHECK_S macros:
@@ -1146,7 +1728,7 @@ namespace loguru
 #define CHECK_WITH_INFO_S(cond, info)                                                              \
 	LOGURU_PREDICT_TRUE((cond) == true)                                                            \
 		? (void)0                                                                                  \
-		: loguru::Voidify() & loguru::AbortLogger("CHECK FAILED:  " info "  ", __FILE__, __LINE__)
+		: loguru::Voidify() & loguru::AbortLogger("CHECK FAILED:  " info "  ", LOGURU_FILE, __LINE__)
 
 #define CHECK_S(cond) CHECK_WITH_INFO_S(cond, #cond)
 #define CHECK_NOTNULL_S(x) CHECK_WITH_INFO_S((x) != nullptr, #x " != nullptr")
@@ -1155,7 +1737,7 @@ namespace loguru
 	while (auto error_string = loguru::function_name(#expr1 " " #op " " #expr2,                    \
 													 loguru::referenceable_value(expr1), #op,      \
 													 loguru::referenceable_value(expr2)))          \
-		loguru::AbortLogger(error_string->c_str(), __FILE__, __LINE__)
+		loguru::AbortLogger(error_string->c_str(), LOGURU_FILE, __LINE__)
 
 #define CHECK_EQ_S(expr1, expr2) CHECK_OP_S(check_EQ_impl, expr1, ==, expr2)
 #define CHECK_NE_S(expr1, expr2) CHECK_OP_S(check_NE_impl, expr1, !=, expr2)
@@ -1175,7 +1757,7 @@ namespace loguru
 	#define DVLOG_IF_S(verbosity, cond)                                                     \
 		(true || (verbosity) > loguru::current_verbosity_cutoff() || (cond) == false)       \
 			? (void)0                                                                       \
-			: loguru::Voidify() & loguru::StreamLogger(verbosity, __FILE__, __LINE__)
+			: loguru::Voidify() & loguru::StreamLogger(verbosity, LOGURU_FILE, __LINE__)
 
 	#define DLOG_IF_S(verbosity_name, cond) DVLOG_IF_S(loguru::Verbosity_ ## verbosity_name, cond)
 	#define DVLOG_S(verbosity)              DVLOG_IF_S(verbosity, true)
@@ -1269,1603 +1851,13 @@ namespace loguru
 // 88 88YbdP88 88"""  88  .o 88""   88YbdP88 88""   88 Y88   88    dP__Yb    88   88 Yb   dP 88 Y88
 // 88 88 YY 88 88     88ood8 888888 88 YY 88 888888 88  Y8   88   dP""""Yb   88   88  YbodP  88  Y8
 
-/* In one of your .cpp files you need to do the following:
-#define LOGURU_IMPLEMENTATION 1
-#include <loguru.hpp>
+/* Add loguru.cpp to your build (or link with the loguru CMake target).
+   For the old single-header setup you may instead, in exactly one .cpp file, do:
 
-This will define all the Loguru functions so that the linker may find them.
+	#define LOGURU_IMPLEMENTATION 1
+	#include <loguru.hpp>
 */
 
 #if defined(LOGURU_IMPLEMENTATION) && !defined(LOGURU_HAS_BEEN_IMPLEMENTED)
-#define LOGURU_HAS_BEEN_IMPLEMENTED
-
-#include <algorithm>
-#include <atomic>
-#include <chrono>
-#include <cstdarg>
-#include <cstdio>
-#include <cstdlib>
-#include <cstring>
-#include <mutex>
-#include <regex>
-#include <string>
-#include <thread>
-#include <vector>
-
-#ifdef _MSC_VER
-	#include <direct.h>
-
-	#define localtime_r(a, b) localtime_s(b, a) // No localtime_r with MSVC, but arguments are swapped for localtime_s
-#else
-	#include <signal.h>
-	#include <sys/stat.h> // mkdir
-	#include <unistd.h>   // STDERR_FILENO
-#endif
-
-#ifdef __linux__
-	#include <linux/limits.h> // PATH_MAX
-#elif !defined(_WIN32)
-	#include <limits.h> // PATH_MAX
-#endif
-
-#ifndef PATH_MAX
-	#define PATH_MAX 1024
-#endif
-
-#ifdef __APPLE__
-	#include "TargetConditionals.h"
-#endif
-
-// TODO: use defined(_POSIX_VERSION) for some of these things?
-
-#if defined(_WIN32) || defined(__CYGWIN__)
-	#define LOGURU_PTHREADS    0
-	#define LOGURU_WINTHREADS  1
-	#define LOGURU_STACKTRACES 0
-#else
-	#define LOGURU_PTHREADS    1
-	#define LOGURU_WINTHREADS  0
-	#define LOGURU_STACKTRACES 1
-#endif
-
-#if LOGURU_STACKTRACES
-	#include <cxxabi.h>    // for __cxa_demangle
-	#include <dlfcn.h>     // for dladdr
-	#include <execinfo.h>  // for backtrace
-#endif // LOGURU_STACKTRACES
-
-#if LOGURU_PTHREADS
-	#include <pthread.h>
-
-	#ifdef __linux__
-		/* On Linux, the default thread name is the same as the name of the binary.
-		   Additionally, all new threads inherit the name of the thread it got forked from.
-		   For this reason, Loguru use the pthread Thread Local Storage
-		   for storing thread names on Linux. */
-		#define LOGURU_PTLS_NAMES 1
-	#endif
-#endif
-
-#if LOGURU_WINTHREADS
-	#ifndef _WIN32_WINNT
-		#define _WIN32_WINNT 0x0502
-	#endif
-	#define WIN32_LEAN_AND_MEAN
-	#define NOMINMAX
-	#include <windows.h>
-#endif
-
-#ifndef LOGURU_PTLS_NAMES
-   #define LOGURU_PTLS_NAMES 0
-#endif
-
-namespace loguru
-{
-	using namespace std::chrono;
-
-#if LOGURU_WITH_FILEABS
-	struct FileAbs
-	{
-		char path[PATH_MAX];
-		char mode_str[4];
-		Verbosity verbosity;
-		struct stat st;
-		FILE* fp;
-		bool is_reopening = false; // to prevent recursive call in file_reopen.
-		decltype(steady_clock::now()) last_check_time = steady_clock::now();
-	};
-#else
-	typedef FILE* FileAbs;
-#endif
-
-	struct Callback
-	{
-		std::string     id;
-		log_handler_t   callback;
-		void*           user_data;
-		Verbosity       verbosity; // Does not change!
-		close_handler_t close;
-		flush_handler_t flush;
-		unsigned        indentation;
-	};
-
-	using CallbackVec = std::vector<Callback>;
-
-	using StringPair     = std::pair<std::string, std::string>;
-	using StringPairList = std::vector<StringPair>;
-
-	const auto SCOPE_TIME_PRECISION = 3; // 3=ms, 6≈us, 9=ns
-
-	const auto s_start_time = steady_clock::now();
-
-	Verbosity g_stderr_verbosity  = Verbosity_0;
-	bool      g_colorlogtostderr  = true;
-	unsigned  g_flush_interval_ms = 0;
-
-	static std::recursive_mutex  s_mutex;
-	static Verbosity             s_max_out_verbosity = Verbosity_OFF;
-	static std::string           s_argv0_filename;
-	static std::string           s_arguments;
-	static char                  s_current_dir[PATH_MAX];
-	static CallbackVec           s_callbacks;
-	static fatal_handler_t       s_fatal_handler   = nullptr;
-	static StringPairList        s_user_stack_cleanups;
-	static bool                  s_strip_file_path = true;
-	static std::atomic<unsigned> s_stderr_indentation { 0 };
-
-	// For periodic flushing:
-	static std::thread* s_flush_thread   = nullptr;
-	static bool         s_needs_flushing = false;
-
-	static const bool s_terminal_has_color = [](){
-		#ifdef _WIN32
-			#ifndef ENABLE_VIRTUAL_TERMINAL_PROCESSING
-			#define ENABLE_VIRTUAL_TERMINAL_PROCESSING  0x0004
-			#endif
-
-			HANDLE hOut = GetStdHandle(STD_OUTPUT_HANDLE);
-			if (hOut != INVALID_HANDLE_VALUE) {
-				DWORD dwMode = 0;
-				GetConsoleMode(hOut, &dwMode);
-				dwMode |= ENABLE_VIRTUAL_TERMINAL_PROCESSING;
-				return SetConsoleMode(hOut, dwMode) != 0;
-			}
-			return false;
-		#else
-			if (const char* term = getenv("TERM")) {
-				return 0 == strcmp(term, "cygwin")
-					|| 0 == strcmp(term, "linux")
-					|| 0 == strcmp(term, "rxvt-unicode-256color")
-					|| 0 == strcmp(term, "screen")
-					|| 0 == strcmp(term, "screen-256color")
-					|| 0 == strcmp(term, "tmux-256color")
-					|| 0 == strcmp(term, "xterm")
-					|| 0 == strcmp(term, "xterm-256color")
-					|| 0 == strcmp(term, "xterm-termite")
-					|| 0 == strcmp(term, "xterm-color");
-			} else {
-				return false;
-			}
-		#endif
-	}();
-
-	const auto PREAMBLE_EXPLAIN = textprintf("date       time         ( uptime  ) [%-*s]%*s:line     v| ",
-											 LOGURU_THREADNAME_WIDTH, " thread name/id",
-											 LOGURU_FILENAME_WIDTH, "file");
-
-	#if LOGURU_PTLS_NAMES
-		static pthread_once_t s_pthread_key_once = PTHREAD_ONCE_INIT;
-		static pthread_key_t  s_pthread_key_name;
-
-		void make_pthread_key_name()
-		{
-			(void)pthread_key_create(&s_pthread_key_name, free);
-		}
-	#endif
-
-	// ------------------------------------------------------------------------------
-	// Colors
-
-	bool terminal_has_color() { return s_terminal_has_color; }
-
-	// Colors
-
-#ifdef _WIN32
-#define VTSEQ(ID) ("\x1b[1;" #ID "m")
-#else
-#define VTSEQ(ID) ("\e[" #ID "m")
-#endif
-
-	const char* terminal_black()      { return s_terminal_has_color ? VTSEQ(30) : ""; }
-	const char* terminal_red()        { return s_terminal_has_color ? VTSEQ(31) : ""; }
-	const char* terminal_green()      { return s_terminal_has_color ? VTSEQ(32) : ""; }
-	const char* terminal_yellow()     { return s_terminal_has_color ? VTSEQ(33) : ""; }
-	const char* terminal_blue()       { return s_terminal_has_color ? VTSEQ(34) : ""; }
-	const char* terminal_purple()     { return s_terminal_has_color ? VTSEQ(35) : ""; }
-	const char* terminal_cyan()       { return s_terminal_has_color ? VTSEQ(36) : ""; }
-	const char* terminal_light_gray() { return s_terminal_has_color ? VTSEQ(37) : ""; }
-	const char* terminal_white()      { return s_terminal_has_color ? VTSEQ(37) : ""; }
-	const char* terminal_light_red()  { return s_terminal_has_color ? VTSEQ(91) : ""; }
-	const char* terminal_dim()        { return s_terminal_has_color ? VTSEQ(2)  : ""; }
-
-	// Formating
-	const char* terminal_bold()       { return s_terminal_has_color ? VTSEQ(1) : ""; }
-	const char* terminal_underline()  { return s_terminal_has_color ? VTSEQ(4) : ""; }
-
-	// You should end each line with this!
-	const char* terminal_reset()      { return s_terminal_has_color ? VTSEQ(0) : ""; }
-
-	// ------------------------------------------------------------------------------
-#if LOGURU_WITH_FILEABS
-	void file_reopen(void* user_data);
-	inline FILE* to_file(void* user_data) { return reinterpret_cast<FileAbs*>(user_data)->fp; }
-#else
-	inline FILE* to_file(void* user_data) { return reinterpret_cast<FILE*>(user_data); }
-#endif
-
-	void file_log(void* user_data, const Message& message)
-	{
-#if LOGURU_WITH_FILEABS
-		FileAbs* file_abs = reinterpret_cast<FileAbs*>(user_data);
-		if (file_abs->is_reopening) {
-			return;
-		}
-		// It is better checking file change every minute/hour/day,
-		// instead of doing this every time we log.
-		// Here check_interval is set to zero to enable checking every time;
-		const auto check_interval = seconds(0);
-		if (duration_cast<seconds>(steady_clock::now() - file_abs->last_check_time) > check_interval) {
-			file_abs->last_check_time = steady_clock::now();
-			file_reopen(user_data);
-		}
-		FILE* file = to_file(user_data);
-		if (!file) {
-			return;
-		}
-#else
-		FILE* file = to_file(user_data);
-#endif
-		fprintf(file, "%s%s%s%s\n",
-			message.preamble, message.indentation, message.prefix, message.message);
-		if (g_flush_interval_ms == 0) {
-			fflush(file);
-		}
-	}
-
-	void file_close(void* user_data)
-	{
-		FILE* file = to_file(user_data);
-		if (file) {
-			fclose(file);
-		}
-#if LOGURU_WITH_FILEABS
-		delete reinterpret_cast<FileAbs*>(user_data);
-#endif
-	}
-
-	void file_flush(void* user_data)
-	{
-		FILE* file = to_file(user_data);
-		fflush(file);
-	}
-
-#if LOGURU_WITH_FILEABS
-	void file_reopen(void* user_data)
-	{
-		FileAbs * file_abs = reinterpret_cast<FileAbs*>(user_data);
-		struct stat st;
-		int ret;
-		if (!file_abs->fp || (ret = stat(file_abs->path, &st)) == -1 || (st.st_ino != file_abs->st.st_ino)) {
-			file_abs->is_reopening = true;
-			if (file_abs->fp) {
-				fclose(file_abs->fp);
-			}
-			if (!file_abs->fp) {
-				LOG_F(INFO, "Reopening file '%s' due to previous error", file_abs->path);
-			}
-			else if (ret < 0) {
-				const auto why = errno_as_text();
-				LOG_F(INFO, "Reopening file '%s' due to '%s'", file_abs->path, why.c_str());
-			} else {
-				LOG_F(INFO, "Reopening file '%s' due to file changed", file_abs->path);
-			}
-			// try reopen current file.
-			if (!create_directories(file_abs->path)) {
-				LOG_F(ERROR, "Failed to create directories to '%s'", file_abs->path);
-			}
-			file_abs->fp = fopen(file_abs->path, file_abs->mode_str);
-			if (!file_abs->fp) {
-				LOG_F(ERROR, "Failed to open '%s'", file_abs->path);
-			} else {
-				stat(file_abs->path, &file_abs->st);
-			}
-			file_abs->is_reopening = false;
-		}
-	}
-#endif
-	// ------------------------------------------------------------------------------
-
-	// Helpers:
-
-	Text::~Text() { free(_str); }
-
-	LOGURU_PRINTF_LIKE(1, 0)
-	static Text vtextprintf(const char* format, va_list vlist)
-	{
-#ifdef _MSC_VER
-		int bytes_needed = _vscprintf(format, vlist);
-		CHECK_F(bytes_needed >= 0, "Bad string format: '%s'", format);
-		char* buff = (char*)malloc(bytes_needed+1);
-		vsnprintf(buff, bytes_needed+1, format, vlist);
-		return Text(buff);
-#else
-		char* buff = nullptr;
-		int result = vasprintf(&buff, format, vlist);
-		CHECK_F(result >= 0, "Bad string format: '%s'", format);
-		return Text(buff);
-#endif
-	}
-
-	Text textprintf(const char* format, ...)
-	{
-		va_list vlist;
-		va_start(vlist, format);
-		auto result = vtextprintf(format, vlist);
-		va_end(vlist);
-		return result;
-	}
-
-	// Overloaded for variadic template matching.
-	Text textprintf()
-	{
-		return Text(static_cast<char*>(calloc(1, 1)));
-	}
-
-	static const char* indentation(unsigned depth)
-	{
-		static const char buff[] =
-		".   .   .   .   .   .   .   .   .   .   " ".   .   .   .   .   .   .   .   .   .   "
-		".   .   .   .   .   .   .   .   .   .   " ".   .   .   .   .   .   .   .   .   .   "
-		".   .   .   .   .   .   .   .   .   .   " ".   .   .   .   .   .   .   .   .   .   "
-		".   .   .   .   .   .   .   .   .   .   " ".   .   .   .   .   .   .   .   .   .   "
-		".   .   .   .   .   .   .   .   .   .   " ".   .   .   .   .   .   .   .   .   .   ";
-		static const size_t INDENTATION_WIDTH = 4;
-		static const size_t NUM_INDENTATIONS = (sizeof(buff) - 1) / INDENTATION_WIDTH;
-		depth = std::min<unsigned>(depth, NUM_INDENTATIONS);
-		return buff + INDENTATION_WIDTH * (NUM_INDENTATIONS - depth);
-	}
-
-	static void parse_args(int& argc, char* argv[], const char* verbosity_flag)
-	{
-		int arg_dest = 1;
-		int out_argc = argc;
-
-		for (int arg_it = 1; arg_it < argc; ++arg_it) {
-			auto cmd = argv[arg_it];
-			auto arg_len = strlen(verbosity_flag);
-			if (strncmp(cmd, verbosity_flag, arg_len) == 0 && !std::isalpha(cmd[arg_len], std::locale(""))) {
-				out_argc -= 1;
-				auto value_str = cmd + arg_len;
-				if (value_str[0] == '\0') {
-					// Value in separate argument
-					arg_it += 1;
-					CHECK_LT_F(arg_it, argc, "Missing verbosiy level after %s", verbosity_flag);
-					value_str = argv[arg_it];
-					out_argc -= 1;
-				}
-				if (*value_str == '=') { value_str += 1; }
-
-				if (strcmp(value_str, "OFF") == 0) {
-					g_stderr_verbosity = Verbosity_OFF;
-				} else if (strcmp(value_str, "INFO") == 0) {
-					g_stderr_verbosity = Verbosity_INFO;
-				} else if (strcmp(value_str, "WARNING") == 0) {
-					g_stderr_verbosity = Verbosity_WARNING;
-				} else if (strcmp(value_str, "ERROR") == 0) {
-					g_stderr_verbosity = Verbosity_ERROR;
-				} else if (strcmp(value_str, "FATAL") == 0) {
-					g_stderr_verbosity = Verbosity_FATAL;
-				} else {
-					char* end = 0;
-					g_stderr_verbosity = static_cast<int>(strtol(value_str, &end, 10));
-					CHECK_F(end && *end == '\0',
-						"Invalid verbosity. Expected integer, INFO, WARNING, ERROR or OFF, got '%s'", value_str);
-				}
-			} else {
-				argv[arg_dest++] = argv[arg_it];
-			}
-		}
-
-		argc = out_argc;
-		argv[argc] = nullptr;
-	}
-
-	static long long now_ns()
-	{
-		return duration_cast<nanoseconds>(high_resolution_clock::now().time_since_epoch()).count();
-	}
-
-	// Returns the part of the path after the last / or \ (if any).
-	const char* filename(const char* path)
-	{
-		for (auto ptr = path; *ptr; ++ptr) {
-			if (*ptr == '/' || *ptr == '\\') {
-				path = ptr + 1;
-			}
-		}
-		return path;
-	}
-
-	// ------------------------------------------------------------------------------
-
-	static void on_atexit()
-	{
-		LOG_F(INFO, "atexit");
-		flush();
-	}
-
-	static void install_signal_handlers();
-
-	static void write_hex_digit(std::string& out, unsigned num)
-	{
-		DCHECK_LT_F(num, 16u);
-		if (num < 10u) { out.push_back(char('0' + num)); }
-		else { out.push_back(char('A' + num - 10)); }
-	}
-
-	static void write_hex_byte(std::string& out, uint8_t n)
-	{
-		write_hex_digit(out, n >> 4u);
-		write_hex_digit(out, n & 0x0f);
-	}
-
-	static void escape(std::string& out, const std::string& str)
-	{
-		for (char c : str) {
-			/**/ if (c == '\a') { out += "\\a";  }
-			else if (c == '\b') { out += "\\b";  }
-			else if (c == '\f') { out += "\\f";  }
-			else if (c == '\n') { out += "\\n";  }
-			else if (c == '\r') { out += "\\r";  }
-			else if (c == '\t') { out += "\\t";  }
-			else if (c == '\v') { out += "\\v";  }
-			else if (c == '\\') { out += "\\\\"; }
-			else if (c == '\'') { out += "\\\'"; }
-			else if (c == '\"') { out += "\\\""; }
-			else if (c == ' ')  { out += "\\ ";  }
-			else if (0 <= c && c < 0x20) { // ASCI control character:
-			// else if (c < 0x20 || c != (c & 127)) { // ASCII control character or UTF-8:
-				out += "\\x";
-				write_hex_byte(out, static_cast<uint8_t>(c));
-			} else { out += c; }
-		}
-	}
-
-	Text errno_as_text()
-	{
-		char buff[256];
-	#ifdef __linux__
-		return Text(strdup(strerror_r(errno, buff, sizeof(buff))));
-	#elif __APPLE__
-		strerror_r(errno, buff, sizeof(buff));
-		return Text(strdup(buff));
-	#elif _WIN32
-		strerror_s(buff, sizeof(buff), errno);
-		return Text(strdup(buff));
-	#else
-		// Not thread-safe.
-		return Text(strdup(strerror(errno)));
-	#endif
-	}
-
-	void init(int& argc, char* argv[], const char* verbosity_flag)
-	{
-		CHECK_GT_F(argc,       0,       "Expected proper argc/argv");
-		CHECK_EQ_F(argv[argc], nullptr, "Expected proper argc/argv");
-
-		s_argv0_filename = filename(argv[0]);
-
-		#ifdef _WIN32
-			#define getcwd _getcwd
-		#endif
-
-		if (!getcwd(s_current_dir, sizeof(s_current_dir)))
-		{
-			const auto error_text = errno_as_text();
-			LOG_F(WARNING, "Failed to get current working directory: %s", error_text.c_str());
-		}
-
-		s_arguments = "";
-		for (int i = 0; i < argc; ++i) {
-			escape(s_arguments, argv[i]);
-			if (i + 1 < argc) {
-				s_arguments += " ";
-			}
-		}
-
-		if (verbosity_flag) {
-			parse_args(argc, argv, verbosity_flag);
-		}
-
-		#if LOGURU_PTLS_NAMES || LOGURU_WINTHREADS
-			set_thread_name("main thread");
-		#elif LOGURU_PTHREADS
-			char old_thread_name[16] = {0};
-			auto this_thread = pthread_self();
-			pthread_getname_np(this_thread, old_thread_name, sizeof(old_thread_name));
-			if (old_thread_name[0] == 0) {
-				#ifdef __APPLE__
-					pthread_setname_np("main thread");
-				#else
-					pthread_setname_np(this_thread, "main thread");
-				#endif
-			}
-		#endif // LOGURU_PTHREADS
-
-		if (g_stderr_verbosity >= Verbosity_INFO) {
-			if (g_colorlogtostderr && s_terminal_has_color) {
-				fprintf(stderr, "%s%s%s\n", terminal_reset(), terminal_dim(), PREAMBLE_EXPLAIN.c_str());
-			} else {
-				fprintf(stderr, "%s\n", PREAMBLE_EXPLAIN.c_str());
-			}
-			fflush(stderr);
-		}
-		LOG_F(INFO, "arguments: %s", s_arguments.c_str());
-		if (strlen(s_current_dir) != 0)
-		{
-			LOG_F(INFO, "Current dir: %s", s_current_dir);
-		}
-		LOG_F(INFO, "stderr verbosity: %d", g_stderr_verbosity);
-		LOG_F(INFO, "-----------------------------------");
-
-		install_signal_handlers();
-
-		atexit(on_atexit);
-	}
-
-	void shutdown()
-	{
-		LOG_F(INFO, "loguru::shutdown()");
-		remove_all_callbacks();
-		set_fatal_handler(nullptr);
-	}
-
-	void write_date_time(char* buff, size_t buff_size)
-	{
-		auto now = system_clock::now();
-		long long ms_since_epoch = duration_cast<milliseconds>(now.time_since_epoch()).count();
-		time_t sec_since_epoch = time_t(ms_since_epoch / 1000);
-		tm time_info;
-		localtime_r(&sec_since_epoch, &time_info);
-		snprintf(buff, buff_size, "%04d%02d%02d_%02d%02d%02d.%03lld",
-			1900 + time_info.tm_year, 1 + time_info.tm_mon, time_info.tm_mday,
-			time_info.tm_hour, time_info.tm_min, time_info.tm_sec, ms_since_epoch % 1000);
-	}
-
-	const char* argv0_filename()
-	{
-		return s_argv0_filename.c_str();
-	}
-
-	const char* arguments()
-	{
-		return s_arguments.c_str();
-	}
-
-	const char* current_dir()
-	{
-		return s_current_dir;
-	}
-
-	const char* home_dir()
-	{
-		#ifdef _WIN32
-			auto user_profile = getenv("USERPROFILE");
-			CHECK_F(user_profile != nullptr, "Missing USERPROFILE");
-			return user_profile;
-		#else // _WIN32
-			auto home = getenv("HOME");
-			CHECK_F(home != nullptr, "Missing HOME");
-			return home;
-		#endif // _WIN32
-	}
-
-	void suggest_log_path(const char* prefix, char* buff, unsigned buff_size)
-	{
-		if (prefix[0] == '~') {
-			snprintf(buff, buff_size - 1, "%s%s", home_dir(), prefix + 1);
-		} else {
-			snprintf(buff, buff_size - 1, "%s", prefix);
-		}
-
-		// Check for terminating /
-		size_t n = strlen(buff);
-		if (n != 0) {
-			if (buff[n - 1] != '/') {
-				CHECK_F(n + 2 < buff_size, "Filename buffer too small");
-				buff[n] = '/';
-				buff[n + 1] = '\0';
-			}
-		}
-
-		strncat(buff, s_argv0_filename.c_str(), buff_size - strlen(buff) - 1);
-		strncat(buff, "/",                      buff_size - strlen(buff) - 1);
-		write_date_time(buff + strlen(buff),    buff_size - strlen(buff));
-		strncat(buff, ".log",                   buff_size - strlen(buff) - 1);
-	}
-
-	bool create_directories(const char* file_path_const)
-	{
-		CHECK_F(file_path_const && *file_path_const);
-		char* file_path = strdup(file_path_const);
-		for (char* p = strchr(file_path + 1, '/'); p; p = strchr(p + 1, '/')) {
-			*p = '\0';
-
-	#ifdef _MSC_VER
-			if (_mkdir(file_path) == -1) {
-	#else
-			if (mkdir(file_path, 0755) == -1) {
-	#endif
-				if (errno != EEXIST) {
-					LOG_F(ERROR, "Failed to create directory '%s'", file_path);
-					LOG_IF_F(ERROR, errno == EACCES,       "EACCES");
-					LOG_IF_F(ERROR, errno == ENAMETOOLONG, "ENAMETOOLONG");
-					LOG_IF_F(ERROR, errno == ENOENT,       "ENOENT");
-					LOG_IF_F(ERROR, errno == ENOTDIR,      "ENOTDIR");
-					LOG_IF_F(ERROR, errno == ELOOP,        "ELOOP");
-
-					*p = '/';
-					free(file_path);
-					return false;
-				}
-			}
-			*p = '/';
-		}
-		free(file_path);
-		return true;
-	}
-	bool add_file(const char* path_in, FileMode mode, Verbosity verbosity)
-	{
-		char path[PATH_MAX];
-		if (path_in[0] == '~') {
-			snprintf(path, sizeof(path) - 1, "%s%s", home_dir(), path_in + 1);
-		} else {
-			snprintf(path, sizeof(path) - 1, "%s", path_in);
-		}
-
-		if (!create_directories(path)) {
-			LOG_F(ERROR, "Failed to create directories to '%s'", path);
-		}
-
-		const char* mode_str = (mode == FileMode::Truncate ? "w" : "a");
-		auto file = fopen(path, mode_str);
-		if (!file) {
-			LOG_F(ERROR, "Failed to open '%s'", path);
-			return false;
-		}
-#if LOGURU_WITH_FILEABS
-		FileAbs* file_abs = new FileAbs(); // this is deleted in file_close;
-		snprintf(file_abs->path, sizeof(file_abs->path) - 1, "%s", path);
-		snprintf(file_abs->mode_str, sizeof(file_abs->mode_str) - 1, "%s", mode_str);
-		stat(file_abs->path, &file_abs->st);
-		file_abs->fp = file;
-		file_abs->verbosity = verbosity;
-		add_callback(path_in, file_log, file_abs, verbosity, file_close, file_flush);
-#else
-		add_callback(path_in, file_log, file, verbosity, file_close, file_flush);
-#endif
-
-		if (mode == FileMode::Append) {
-			fprintf(file, "\n\n\n\n\n");
-		}
-		if (!s_arguments.empty()) {
-			fprintf(file, "arguments: %s\n", s_arguments.c_str());
-		}
-		if (strlen(s_current_dir) != 0) {
-			fprintf(file, "Current dir: %s\n", s_current_dir);
-		}
-		fprintf(file, "File verbosity level: %d\n", verbosity);
-		fprintf(file, "%s\n", PREAMBLE_EXPLAIN.c_str());
-		fflush(file);
-
-		LOG_F(INFO, "Logging to '%s', mode: '%s', verbosity: %d", path, mode_str, verbosity);
-		return true;
-	}
-
-	// Will be called right before abort().
-	void set_fatal_handler(fatal_handler_t handler)
-	{
-		s_fatal_handler = handler;
-	}
-
-	void add_stack_cleanup(const char* find_this, const char* replace_with_this)
-	{
-		if (strlen(find_this) <= strlen(replace_with_this)) {
-			LOG_F(WARNING, "add_stack_cleanup: the replacement should be shorter than the pattern!");
-			return;
-		}
-
-		s_user_stack_cleanups.push_back(StringPair(find_this, replace_with_this));
-	}
-
-	static void on_callback_change()
-	{
-		s_max_out_verbosity = Verbosity_OFF;
-		for (const auto& callback : s_callbacks) {
-			s_max_out_verbosity = std::max(s_max_out_verbosity, callback.verbosity);
-		}
-	}
-
-	void add_callback(const char* id, log_handler_t callback, void* user_data,
-					  Verbosity verbosity, close_handler_t on_close, flush_handler_t on_flush)
-	{
-		std::lock_guard<std::recursive_mutex> lock(s_mutex);
-		s_callbacks.push_back(Callback{id, callback, user_data, verbosity, on_close, on_flush, 0});
-		on_callback_change();
-	}
-
-	bool remove_callback(const char* id)
-	{
-		std::lock_guard<std::recursive_mutex> lock(s_mutex);
-		auto it = std::find_if(begin(s_callbacks), end(s_callbacks), [&](const Callback& c) { return c.id == id; });
-		if (it != s_callbacks.end()) {
-			if (it->close) { it->close(it->user_data); }
-			s_callbacks.erase(it);
-			on_callback_change();
-			return true;
-		} else {
-			LOG_F(ERROR, "Failed to locate callback with id '%s'", id);
-			return false;
-		}
-	}
-
-	void remove_all_callbacks()
-	{
-		std::lock_guard<std::recursive_mutex> lock(s_mutex);
-		for (auto& callback : s_callbacks) {
-			if (callback.close) {
-				callback.close(callback.user_data);
-			}
-		}
-		s_callbacks.clear();
-		on_callback_change();
-	}
-
-	// Returns the maximum of g_stderr_verbosity and all file/custom outputs.
-	Verbosity current_verbosity_cutoff()
-	{
-		return g_stderr_verbosity > s_max_out_verbosity ?
-			   g_stderr_verbosity : s_max_out_verbosity;
-	}
-
-#if LOGURU_WINTHREADS
-	char* get_thread_name_win32()
-	{
-		__declspec( thread ) static char thread_name[LOGURU_THREADNAME_WIDTH + 1] = {0};
-		return &thread_name[0];
-	}
-#endif // LOGURU_WINTHREADS
-
-	void set_thread_name(const char* name)
-	{
-		#if LOGURU_PTLS_NAMES
-			(void)pthread_once(&s_pthread_key_once, make_pthread_key_name);
-			(void)pthread_setspecific(s_pthread_key_name, strdup(name));
-
-		#elif LOGURU_PTHREADS
-			#ifdef __APPLE__
-				pthread_setname_np(name);
-			#else
-				pthread_setname_np(pthread_self(), name);
-			#endif
-		#elif LOGURU_WINTHREADS
-			strncpy_s(get_thread_name_win32(), LOGURU_THREADNAME_WIDTH + 1, name, _TRUNCATE);
-		#else // LOGURU_PTHREADS
-			(void)name;
-		#endif // LOGURU_PTHREADS
-	}
-
-#if LOGURU_PTLS_NAMES
-	const char* get_thread_name_ptls()
-	{
-		(void)pthread_once(&s_pthread_key_once, make_pthread_key_name);
-		return static_cast<const char*>(pthread_getspecific(s_pthread_key_name));
-	}
-#endif // LOGURU_PTLS_NAMES
-
-	void get_thread_name(char* buffer, unsigned long long length, bool right_align_hext_id)
-	{
-		CHECK_NE_F(length, 0u, "Zero length buffer in get_thread_name");
-		CHECK_NOTNULL_F(buffer, "nullptr in get_thread_name");
-#if LOGURU_PTHREADS
-		auto thread = pthread_self();
-		#if LOGURU_PTLS_NAMES
-			if (const char* name = get_thread_name_ptls()) {
-				snprintf(buffer, length, "%s", name);
-			} else {
-				buffer[0] = 0;
-			}
-		#else
-			pthread_getname_np(thread, buffer, length);
-		#endif
-
-		if (buffer[0] == 0) {
-			#ifdef __APPLE__
-				uint64_t thread_id;
-				pthread_threadid_np(thread, &thread_id);
-			#else
-				uint64_t thread_id = thread;
-			#endif
-			if (right_align_hext_id) {
-				snprintf(buffer, length, "%*X", length - 1, static_cast<unsigned>(thread_id));
-			} else {
-				snprintf(buffer, length, "%X", static_cast<unsigned>(thread_id));
-			}
-		}
-#elif LOGURU_WINTHREADS
-		if (const char* name = get_thread_name_win32()) {
-			snprintf(buffer, (size_t)length, "%s", name);
-		} else {
-			buffer[0] = 0;
-		}
-#else // !LOGURU_WINTHREADS && !LOGURU_WINTHREADS
-		buffer[0] = 0;
-#endif
-
-	}
-
-	// ------------------------------------------------------------------------
-	// Stack traces
-
-#if LOGURU_STACKTRACES
-	Text demangle(const char* name)
-	{
-		int status = -1;
-		char* demangled = abi::__cxa_demangle(name, 0, 0, &status);
-		Text result{status == 0 ? demangled : strdup(name)};
-		return result;
-	}
-
-	template <class T>
-	std::string type_name() {
-		auto demangled = demangle(typeid(T).name());
-		return demangled.c_str();
-	}
-
-	static const StringPairList REPLACE_LIST = {
-		{ type_name<std::string>(),    "std::string"    },
-		{ type_name<std::wstring>(),   "std::wstring"   },
-		{ type_name<std::u16string>(), "std::u16string" },
-		{ type_name<std::u32string>(), "std::u32string" },
-		{ "std::__1::",                "std::"          },
-		{ "__thiscall ",               ""               },
-		{ "__cdecl ",                  ""               },
-	};
-
-	void do_replacements(const StringPairList& replacements, std::string& str)
-	{
-		for (auto&& p : replacements) {
-			if (p.first.size() <= p.second.size()) {
-				// On gcc, "type_name<std::string>()" is "std::string"
-				continue;
-			}
-
-			size_t it;
-			while ((it=str.find(p.first)) != std::string::npos) {
-				str.replace(it, p.first.size(), p.second);
-			}
-		}
-	}
-
-	std::string prettify_stacktrace(const std::string& input)
-	{
-		std::string output = input;
-
-		do_replacements(s_user_stack_cleanups, output);
-		do_replacements(REPLACE_LIST, output);
-
-		try {
-			std::regex std_allocator_re(R"(,\s*std::allocator<[^<>]+>)");
-			output = std::regex_replace(output, std_allocator_re, std::string(""));
-
-			std::regex template_spaces_re(R"(<\s*([^<> ]+)\s*>)");
-			output = std::regex_replace(output, template_spaces_re, std::string("<$1>"));
-		} catch (std::regex_error&) {
-			// Probably old GCC.
-		}
-
-		return output;
-	}
-
-	std::string stacktrace_as_stdstring(int skip)
-	{
-		// From https://gist.github.com/fmela/591333
-		void* callstack[128];
-		const auto max_frames = sizeof(callstack) / sizeof(callstack[0]);
-		int num_frames = backtrace(callstack, max_frames);
-		char** symbols = backtrace_symbols(callstack, num_frames);
-
-		std::string result;
-		// Print stack traces so the most relevant ones are written last
-		// Rationale: http://yellerapp.com/posts/2015-01-22-upside-down-stacktraces.html
-		for (int i = num_frames - 1; i >= skip; --i) {
-			char buf[1024];
-			Dl_info info;
-			if (dladdr(callstack[i], &info) && info.dli_sname) {
-				char* demangled = NULL;
-				int status = -1;
-				if (info.dli_sname[0] == '_') {
-					demangled = abi::__cxa_demangle(info.dli_sname, 0, 0, &status);
-				}
-				snprintf(buf, sizeof(buf), "%-3d %*p %s + %zd\n",
-						 i - skip, int(2 + sizeof(void*) * 2), callstack[i],
-						 status == 0 ? demangled :
-						 info.dli_sname == 0 ? symbols[i] : info.dli_sname,
-						 static_cast<char*>(callstack[i]) - static_cast<char*>(info.dli_saddr));
-				free(demangled);
-			} else {
-				snprintf(buf, sizeof(buf), "%-3d %*p %s\n",
-						 i - skip, int(2 + sizeof(void*) * 2), callstack[i], symbols[i]);
-			}
-			result += buf;
-		}
-		free(symbols);
-
-		if (num_frames == max_frames) {
-			result = "[truncated]\n" + result;
-		}
-
-		if (!result.empty() && result[result.size() - 1] == '\n') {
-			result.resize(result.size() - 1);
-		}
-
-		return prettify_stacktrace(result);
-	}
-
-#else // LOGURU_STACKTRACES
-	Text demangle(const char* name)
-	{
-		return Text(strdup(name));
-	}
-
-	std::string stacktrace_as_stdstring(int)
-	{
-		#if defined(_MSC_VER)
-		#pragma message ( "Loguru: No stacktraces available on this platform" )
-		#else
-		#warning "Loguru: No stacktraces available on this platform"
-		#endif
-		return "";
-	}
-
-#endif // LOGURU_STACKTRACES
-
-	Text stacktrace(int skip)
-	{
-		auto str = stacktrace_as_stdstring(skip + 1);
-		return Text(strdup(str.c_str()));
-	}
-
-	// ------------------------------------------------------------------------
-
-	static void print_preamble(char* out_buff, size_t out_buff_size, Verbosity verbosity, const char* file, unsigned line)
-	{
-		long long ms_since_epoch = duration_cast<milliseconds>(system_clock::now().time_since_epoch()).count();
-		time_t sec_since_epoch = time_t(ms_since_epoch / 1000);
-		tm time_info;
-		localtime_r(&sec_since_epoch, &time_info);
-
-		auto uptime_ms = duration_cast<milliseconds>(steady_clock::now() - s_start_time).count();
-		auto uptime_sec = uptime_ms / 1000.0;
-
-		char thread_name[LOGURU_THREADNAME_WIDTH + 1] = {0};
-		get_thread_name(thread_name, LOGURU_THREADNAME_WIDTH + 1, true);
-
-		if (s_strip_file_path) {
-			file = filename(file);
-		}
-
-		char level_buff[6];
-		if (verbosity <= Verbosity_FATAL) {
-			snprintf(level_buff, sizeof(level_buff) - 1, "FATL");
-		} else if (verbosity == Verbosity_ERROR) {
-			snprintf(level_buff, sizeof(level_buff) - 1, "ERR");
-		} else if (verbosity == Verbosity_WARNING) {
-			snprintf(level_buff, sizeof(level_buff) - 1, "WARN");
-		} else {
-			snprintf(level_buff, sizeof(level_buff) - 1, "% 4d", verbosity);
-		}
-
-		snprintf(out_buff, out_buff_size, "%04d-%02d-%02d %02d:%02d:%02d.%03lld (%8.3fs) [%-*s]%*s:%-5u %4s| ",
-			1900 + time_info.tm_year, 1 + time_info.tm_mon, time_info.tm_mday,
-			time_info.tm_hour, time_info.tm_min, time_info.tm_sec, ms_since_epoch % 1000,
-			uptime_sec,
-			LOGURU_THREADNAME_WIDTH, thread_name,
-			LOGURU_FILENAME_WIDTH,
-			file, line, level_buff);
-	}
-
-	// stack_trace_skip is just if verbosity == FATAL.
-	static void log_message(int stack_trace_skip, Message& message, bool with_indentation, bool abort_if_fatal)
-	{
-		const auto verbosity = message.verbosity;
-		std::lock_guard<std::recursive_mutex> lock(s_mutex);
-
-		if (message.verbosity == Verbosity_FATAL) {
-			auto st = loguru::stacktrace(stack_trace_skip + 2);
-			if (!st.empty()) {
-				RAW_LOG_F(ERROR, "Stack trace:\n%s", st.c_str());
-			}
-
-			auto ec = loguru::get_error_context();
-			if (!ec.empty()) {
-				RAW_LOG_F(ERROR, "%s", ec.c_str());
-			}
-		}
-
-		if (with_indentation) {
-			message.indentation = indentation(s_stderr_indentation);
-		}
-
-		if (verbosity <= g_stderr_verbosity) {
-			if (g_colorlogtostderr && s_terminal_has_color) {
-				if (verbosity > Verbosity_WARNING) {
-					fprintf(stderr, "%s%s%s%s%s%s%s%s%s\n",
-						terminal_reset(),
-						terminal_dim(),
-						message.preamble,
-						message.indentation,
-						terminal_reset(),
-						verbosity == Verbosity_INFO ? terminal_bold() : terminal_light_gray(),
-						message.prefix,
-						message.message,
-						terminal_reset());
-				} else {
-					fprintf(stderr, "%s%s%s%s%s%s%s%s\n",
-						terminal_reset(),
-						terminal_bold(),
-						verbosity == Verbosity_WARNING ? terminal_red() : terminal_light_red(),
-						message.preamble,
-						message.indentation,
-						message.prefix,
-						message.message,
-						terminal_reset());
-				}
-			} else {
-				fprintf(stderr, "%s%s%s%s\n",
-					message.preamble, message.indentation, message.prefix, message.message);
-			}
-
-			if (g_flush_interval_ms == 0) {
-				fflush(stderr);
-			} else {
-				s_needs_flushing = true;
-			}
-		}
-
-		for (auto& p : s_callbacks) {
-			if (verbosity <= p.verbosity) {
-				if (with_indentation) {
-					message.indentation = indentation(p.indentation);
-				}
-				p.callback(p.user_data, message);
-				if (g_flush_interval_ms == 0) {
-					if (p.flush) { p.flush(p.user_data); }
-				} else {
-					s_needs_flushing = true;
-				}
-			}
-		}
-
-		if (g_flush_interval_ms > 0 && !s_flush_thread) {
-			s_flush_thread = new std::thread([](){
-				for (;;) {
-					if (s_needs_flushing) {
-						flush();
-					}
-					std::this_thread::sleep_for(std::chrono::milliseconds(g_flush_interval_ms));
-				}
-			});
-		}
-
-		if (message.verbosity == Verbosity_FATAL) {
-			flush();
-
-			if (s_fatal_handler) {
-				s_fatal_handler(message);
-				flush();
-			}
-
-			if (abort_if_fatal) {
-#if LOGURU_CATCH_SIGABRT && !defined(_WIN32)
-				// Make sure we don't catch our own abort:
-				signal(SIGABRT, SIG_DFL);
-#endif
-				abort();
-			}
-		}
-	}
-
-	// stack_trace_skip is just if verbosity == FATAL.
-	void log_to_everywhere(int stack_trace_skip, Verbosity verbosity,
-						   const char* file, unsigned line,
-						   const char* prefix, const char* buff)
-	{
-		char preamble_buff[128];
-		print_preamble(preamble_buff, sizeof(preamble_buff), verbosity, file, line);
-		auto message = Message{verbosity, file, line, preamble_buff, "", prefix, buff};
-		log_message(stack_trace_skip + 1, message, true, true);
-	}
-
-#if LOGURU_USE_FMTLIB
-	void log(Verbosity verbosity, const char* file, unsigned line, const char* format, fmt::ArgList args)
-	{
-		auto formatted = fmt::format(format, args);
-		log_to_everywhere(1, verbosity, file, line, "", formatted.c_str());
-	}
-
-	void raw_log(Verbosity verbosity, const char* file, unsigned line, const char* format, fmt::ArgList args)
-	{
-		auto formatted = fmt::format(format, args);
-		auto message = Message{verbosity, file, line, "", "", "", formatted.c_str()};
-		log_message(1, message, false, true);
-	}
-
-#else
-	void log(Verbosity verbosity, const char* file, unsigned line, const char* format, ...)
-	{
-		va_list vlist;
-		va_start(vlist, format);
-		auto buff = vtextprintf(format, vlist);
-		log_to_everywhere(1, verbosity, file, line, "", buff.c_str());
-		va_end(vlist);
-	}
-
-	void raw_log(Verbosity verbosity, const char* file, unsigned line, const char* format, ...)
-	{
-		va_list vlist;
-		va_start(vlist, format);
-		auto buff = vtextprintf(format, vlist);
-		auto message = Message{verbosity, file, line, "", "", "", buff.c_str()};
-		log_message(1, message, false, true);
-		va_end(vlist);
-	}
-#endif
-
-	void flush()
-	{
-		std::lock_guard<std::recursive_mutex> lock(s_mutex);
-		fflush(stderr);
-		for (const auto& callback : s_callbacks)
-		{
-			if (callback.flush) {
-				callback.flush(callback.user_data);
-			}
-		}
-		s_needs_flushing = false;
-	}
-
-	LogScopeRAII::LogScopeRAII(Verbosity verbosity, const char* file, unsigned line, const char* format, ...)
-		: _verbosity(verbosity), _file(file), _line(line)
-	{
-		if (verbosity <= current_verbosity_cutoff()) {
-			std::lock_guard<std::recursive_mutex> lock(s_mutex);
-			_indent_stderr = (verbosity <= g_stderr_verbosity);
-			_start_time_ns = now_ns();
-			va_list vlist;
-			va_start(vlist, format);
-			vsnprintf(_name, sizeof(_name), format, vlist);
-			log_to_everywhere(1, _verbosity, file, line, "{ ", _name);
-			va_end(vlist);
-
-			if (_indent_stderr) {
-				++s_stderr_indentation;
-			}
-
-			for (auto& p : s_callbacks) {
-				if (verbosity <= p.verbosity) {
-					++p.indentation;
-				}
-			}
-		} else {
-			_file = nullptr;
-		}
-	}
-
-	LogScopeRAII::~LogScopeRAII()
-	{
-		if (_file) {
-			std::lock_guard<std::recursive_mutex> lock(s_mutex);
-			if (_indent_stderr && s_stderr_indentation > 0) {
-				--s_stderr_indentation;
-			}
-			for (auto& p : s_callbacks) {
-				// Note: Callback indentation cannot change!
-				if (_verbosity <= p.verbosity) {
-					// in unlikely case this callback is new
-					if (p.indentation > 0) {
-						--p.indentation;
-					}
-				}
-			}
-			auto duration_sec = (now_ns() - _start_time_ns) / 1e9;
-			log(_verbosity, _file, _line, "} %.*f s: %s", SCOPE_TIME_PRECISION, duration_sec, _name);
-		}
-	}
-
-	void log_and_abort(int stack_trace_skip, const char* expr, const char* file, unsigned line, const char* format, ...)
-	{
-		va_list vlist;
-		va_start(vlist, format);
-		auto buff = vtextprintf(format, vlist);
-		log_to_everywhere(stack_trace_skip + 1, Verbosity_FATAL, file, line, expr, buff.c_str());
-		va_end(vlist);
-		abort(); // log_to_everywhere already does this, but this makes the analyzer happy.
-	}
-
-	void log_and_abort(int stack_trace_skip, const char* expr, const char* file, unsigned line)
-	{
-		log_and_abort(stack_trace_skip + 1, expr, file, line, " ");
-	}
-
-	// ----------------------------------------------------------------------------
-	// Streams:
-
-	std::string vstrprintf(const char* format, va_list vlist)
-	{
-		auto text = vtextprintf(format, vlist);
-		std::string result = text.c_str();
-		return result;
-	}
-
-	std::string strprintf(const char* format, ...)
-	{
-		va_list vlist;
-		va_start(vlist, format);
-		auto result = vstrprintf(format, vlist);
-		va_end(vlist);
-		return result;
-	}
-
-	#if LOGURU_WITH_STREAMS
-
-	StreamLogger::~StreamLogger() noexcept(false)
-	{
-		auto message = _ss.str();
-		log(_verbosity, _file, _line, "%s", message.c_str());
-	}
-
-	AbortLogger::~AbortLogger() noexcept(false)
-	{
-		auto message = _ss.str();
-		loguru::log_and_abort(1, _expr, _file, _line, "%s", message.c_str());
-	}
-
-	#endif // LOGURU_WITH_STREAMS
-
-	// ----------------------------------------------------------------------------
-	// 888888 88""Yb 88""Yb  dP"Yb  88""Yb      dP""b8  dP"Yb  88b 88 888888 888888 Yb  dP 888888
-	// 88__   88__dP 88__dP dP   Yb 88__dP     dP   `" dP   Yb 88Yb88   88   88__    YbdP    88
-	// 88""   88"Yb  88"Yb  Yb   dP 88"Yb      Yb      Yb   dP 88 Y88   88   88""    dPYb    88
-	// 888888 88  Yb 88  Yb  YbodP  88  Yb      YboodP  YbodP  88  Y8   88   888888 dP  Yb   88
-	// ----------------------------------------------------------------------------
-
-	struct StringStream
-	{
-		std::string str;
-	};
-
-	// Use this in your EcPrinter implementations.
-	void stream_print(StringStream& out_string_stream, const char* text)
-	{
-		out_string_stream.str += text;
-	}
-
-	// ----------------------------------------------------------------------------
-
-	using ECPtr = EcEntryBase*;
-
-#if defined(_WIN32) || (defined(__APPLE__) && !TARGET_OS_IPHONE)
-	#ifdef __APPLE__
-		#define LOGURU_THREAD_LOCAL __thread
-	#else
-		#define LOGURU_THREAD_LOCAL thread_local
-	#endif
-	static LOGURU_THREAD_LOCAL ECPtr thread_ec_ptr = nullptr;
-
-	ECPtr& get_thread_ec_head_ref()
-	{
-		return thread_ec_ptr;
-	}
-#else // !thread_local
-	static pthread_once_t s_ec_pthread_once = PTHREAD_ONCE_INIT;
-	static pthread_key_t  s_ec_pthread_key;
-
-	void free_ec_head_ref(void* io_error_context)
-	{
-		delete reinterpret_cast<ECPtr*>(io_error_context);
-	}
-
-	void ec_make_pthread_key()
-	{
-		(void)pthread_key_create(&s_ec_pthread_key, free_ec_head_ref);
-	}
-
-	ECPtr& get_thread_ec_head_ref()
-	{
-		(void)pthread_once(&s_ec_pthread_once, ec_make_pthread_key);
-		auto ec = reinterpret_cast<ECPtr*>(pthread_getspecific(s_ec_pthread_key));
-		if (ec == nullptr) {
-			ec = new ECPtr(nullptr);
-			(void)pthread_setspecific(s_ec_pthread_key, ec);
-		}
-		return *ec;
-	}
-#endif // !thread_local
-
-	// ----------------------------------------------------------------------------
-
-	EcHandle get_thread_ec_handle()
-	{
-		return get_thread_ec_head_ref();
-	}
-
-	Text get_error_context()
-	{
-		return get_error_context_for(get_thread_ec_head_ref());
-	}
-
-	Text get_error_context_for(const EcEntryBase* ec_head)
-	{
-		std::vector<const EcEntryBase*> stack;
-		while (ec_head) {
-			stack.push_back(ec_head);
-			ec_head = ec_head->_previous;
-		}
-		std::reverse(stack.begin(), stack.end());
-
-		StringStream result;
-		if (!stack.empty()) {
-			result.str += "------------------------------------------------\n";
-			for (auto entry : stack) {
-				const auto description = std::string(entry->_descr) + ":";
-				auto prefix = textprintf("[ErrorContext] %*s:%-5u %-20s ",
-					LOGURU_FILENAME_WIDTH, filename(entry->_file), entry->_line, description.c_str());
-				result.str += prefix.c_str();
-				entry->print_value(result);
-				result.str += "\n";
-			}
-			result.str += "------------------------------------------------";
-		}
-		return Text(strdup(result.str.c_str()));
-	}
-
-	EcEntryBase::EcEntryBase(const char* file, unsigned line, const char* descr)
-		: _file(file), _line(line), _descr(descr)
-	{
-		EcEntryBase*& ec_head = get_thread_ec_head_ref();
-		_previous = ec_head;
-		ec_head = this;
-	}
-
-	EcEntryBase::~EcEntryBase()
-	{
-		get_thread_ec_head_ref() = _previous;
-	}
-
-	// ------------------------------------------------------------------------
-
-	Text ec_to_text(const char* value)
-	{
-		// Add quotes around the string to make it obvious where it begin and ends.
-		// This is great for detecting erroneous leading or trailing spaces in e.g. an identifier.
-		auto str = "\"" + std::string(value) + "\"";
-		return Text{strdup(str.c_str())};
-	}
-
-	Text ec_to_text(char c)
-	{
-		// Add quotes around the character to make it obvious where it begin and ends.
-		std::string str = "'";
-
-		auto write_hex_digit = [&](unsigned num)
-		{
-			if (num < 10u) { str += char('0' + num); }
-			else           { str += char('a' + num - 10); }
-		};
-
-		auto write_hex_16 = [&](uint16_t n)
-		{
-			write_hex_digit((n >> 12u) & 0x0f);
-			write_hex_digit((n >>  8u) & 0x0f);
-			write_hex_digit((n >>  4u) & 0x0f);
-			write_hex_digit((n >>  0u) & 0x0f);
-		};
-
-		if      (c == '\\') { str += "\\\\"; }
-		else if (c == '\"') { str += "\\\""; }
-		else if (c == '\'') { str += "\\\'"; }
-		else if (c == '\0') { str += "\\0";  }
-		else if (c == '\b') { str += "\\b";  }
-		else if (c == '\f') { str += "\\f";  }
-		else if (c == '\n') { str += "\\n";  }
-		else if (c == '\r') { str += "\\r";  }
-		else if (c == '\t') { str += "\\t";  }
-		else if (0 <= c && c < 0x20) {
-			str += "\\u";
-			write_hex_16(static_cast<uint16_t>(c));
-		} else { str += c; }
-
-		str += "'";
-
-		return Text{strdup(str.c_str())};
-	}
-
-	#define DEFINE_EC(Type)                        \
-		Text ec_to_text(Type value)                \
-		{                                          \
-			auto str = std::to_string(value);      \
-			return Text{strdup(str.c_str())};      \
-		}
-
-	DEFINE_EC(int)
-	DEFINE_EC(unsigned int)
-	DEFINE_EC(long)
-	DEFINE_EC(unsigned long)
-	DEFINE_EC(long long)
-	DEFINE_EC(unsigned long long)
-	DEFINE_EC(float)
-	DEFINE_EC(double)
-	DEFINE_EC(long double)
-
-	#undef DEFINE_EC
-
-	Text ec_to_text(EcHandle ec_handle)
-	{
-		Text parent_ec = get_error_context_for(ec_handle);
-		char* with_newline = (char*)malloc(strlen(parent_ec.c_str()) + 2);
-		with_newline[0] = '\n';
-		strcpy(with_newline + 1, parent_ec.c_str());
-		return Text(with_newline);
-	}
-
-	// ----------------------------------------------------------------------------
-
-} // namespace loguru
-
-// ----------------------------------------------------------------------------
-// .dP"Y8 88  dP""b8 88b 88    db    88     .dP"Y8
-// `Ybo." 88 dP   `" 88Yb88   dPYb   88     `Ybo."
-// o.`Y8b 88 Yb  "88 88 Y88  dP__Yb  88  .o o.`Y8b
-// 8bodP' 88  YboodP 88  Y8 dP""""Yb 88ood8 8bodP'
-// ----------------------------------------------------------------------------
-
-#ifdef _WIN32
-namespace loguru {
-	void install_signal_handlers()
-	{
-		#if defined(_MSC_VER)
-		#pragma message ( "No signal handlers on Win32" )
-		#else
-		#warning "No signal handlers on Win32"
-		#endif
-	}
-} // namespace loguru
-
-#else // _WIN32
-
-namespace loguru
-{
-	struct Signal
-	{
-		int         number;
-		const char* name;
-	};
-	const Signal ALL_SIGNALS[] = {
-#if LOGURU_CATCH_SIGABRT
-		{ SIGABRT, "SIGABRT" },
-#endif
-		{ SIGBUS,  "SIGBUS"  },
-		{ SIGFPE,  "SIGFPE"  },
-		{ SIGILL,  "SIGILL"  },
-		{ SIGINT,  "SIGINT"  },
-		{ SIGSEGV, "SIGSEGV" },
-		{ SIGTERM, "SIGTERM" },
-	};
-
-	void write_to_stderr(const char* data, size_t size)
-	{
-		auto result = write(STDERR_FILENO, data, size);
-		(void)result; // Ignore errors.
-	}
-
-	void write_to_stderr(const char* data)
-	{
-		write_to_stderr(data, strlen(data));
-	}
-
-	void call_default_signal_handler(int signal_number)
-	{
-		struct sigaction sig_action;
-		memset(&sig_action, 0, sizeof(sig_action));
-		sigemptyset(&sig_action.sa_mask);
-		sig_action.sa_handler = SIG_DFL;
-		sigaction(signal_number, &sig_action, NULL);
-		kill(getpid(), signal_number);
-	}
-
-	void signal_handler(int signal_number, siginfo_t*, void*)
-	{
-		const char* signal_name = "UNKNOWN SIGNAL";
-
-		for (const auto& s : ALL_SIGNALS) {
-			if (s.number == signal_number) {
-				signal_name = s.name;
-				break;
-			}
-		}
-
-		// --------------------------------------------------------------------
-		/* There are few things that are safe to do in a signal handler,
-		   but writing to stderr is one of them.
-		   So we first print out what happened to stderr so we're sure that gets out,
-		   then we do the unsafe things, like logging the stack trace.
-		*/
-
-		if (g_colorlogtostderr && s_terminal_has_color) {
-			write_to_stderr(terminal_reset());
-			write_to_stderr(terminal_bold());
-			write_to_stderr(terminal_light_red());
-		}
-		write_to_stderr("\n");
-		write_to_stderr("Loguru caught a signal: ");
-		write_to_stderr(signal_name);
-		write_to_stderr("\n");
-		if (g_colorlogtostderr && s_terminal_has_color) {
-			write_to_stderr(terminal_reset());
-		}
-
-		// --------------------------------------------------------------------
-
-#if LOGURU_UNSAFE_SIGNAL_HANDLER
-		// --------------------------------------------------------------------
-		/* Now we do unsafe things. This can for example lead to deadlocks if
-		   the signal was triggered from the system's memory management functions
-		   and the code below tries to do allocations.
-		*/
-
-		flush();
-		char preamble_buff[128];
-		print_preamble(preamble_buff, sizeof(preamble_buff), Verbosity_FATAL, "", 0);
-		auto message = Message{Verbosity_FATAL, "", 0, preamble_buff, "", "Signal: ", signal_name};
-		try {
-			log_message(1, message, false, false);
-		} catch (...) {
-			// This can happed due to s_fatal_handler.
-			write_to_stderr("Exception caught and ignored by Loguru signal handler.\n");
-		}
-		flush();
-
-		// --------------------------------------------------------------------
-#endif // LOGURU_UNSAFE_SIGNAL_HANDLER
-
-		call_default_signal_handler(signal_number);
-	}
-
-	void install_signal_handlers()
-	{
-		struct sigaction sig_action;
-		memset(&sig_action, 0, sizeof(sig_action));
-		sigemptyset(&sig_action.sa_mask);
-		sig_action.sa_flags |= SA_SIGINFO;
-		sig_action.sa_sigaction = &signal_handler;
-		for (const auto& s : ALL_SIGNALS) {
-			CHECK_F(sigaction(s.number, &sig_action, NULL) != -1,
-				"Failed to install handler for %s", s.name);
-		}
-	}
-} // namespace loguru
-
-#endif // _WIN32
-
+	#include "loguru.cpp"
 #endif // LOGURU_IMPLEMENTATION
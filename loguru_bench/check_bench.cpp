@@ -0,0 +1,38 @@
+// Hundreds of CHECK:s that never fail, to measure what they cost in code size and run time.
+// For the code size, compare `size CMakeFiles/loguru_bench.dir/check_bench.cpp.o` between versions of loguru.hpp.
+
+#define LOGURU_WITH_STREAMS 1
+#include "../loguru.hpp"
+
+#define CHECKS_F_4(i)                                  \
+	CHECK_GE_F(values[i], 0, "values[%d]", i);         \
+	CHECK_LT_F(values[i], 1000);                       \
+	CHECK_NE_F(values[i], values[i + 1] + 1000);       \
+	CHECK_F(values[i] != 1000, "values[%d] = %d", i, values[i]); \
+	sum += values[i];
+
+#define CHECKS_S_4(i)                                  \
+	CHECK_GE_S(values[i], 0) << "values[" << i << "]"; \
+	CHECK_LT_S(values[i], 1000);                       \
+	CHECK_NE_S(values[i], values[i + 1] + 1000);       \
+	CHECK_S(values[i] != 1000) << values[i];           \
+	sum += values[i];
+
+#define CHECKS_16(CHECKS_4, i) CHECKS_4(i) CHECKS_4(i + 1) CHECKS_4(i + 2) CHECKS_4(i + 3)
+#define CHECKS_64(CHECKS_4, i) CHECKS_16(CHECKS_4, i) CHECKS_16(CHECKS_4, i + 4) CHECKS_16(CHECKS_4, i + 8) CHECKS_16(CHECKS_4, i + 12)
+#define CHECKS_256(CHECKS_4, i) CHECKS_64(CHECKS_4, i) CHECKS_64(CHECKS_4, i + 16) CHECKS_64(CHECKS_4, i + 32) CHECKS_64(CHECKS_4, i + 48)
+
+// values must have at least 65 elements, all in [0, 1000).
+int run_checks_f(const int* values)
+{
+	int sum = 0;
+	CHECKS_256(CHECKS_F_4, 0)
+	return sum;
+}
+
+int run_checks_s(const int* values)
+{
+	int sum = 0;
+	CHECKS_256(CHECKS_S_4, 0)
+	return sum;
+}
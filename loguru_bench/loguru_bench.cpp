@@ -6,7 +6,6 @@
 
 #define LOGURU_WITH_STREAMS 1
 #define LOGURU_REDEFINE_ASSERT 1
-#define LOGURU_IMPLEMENTATION 1
 #include "../loguru.hpp"
 
 const size_t kNumRuns = 10;
@@ -97,6 +96,29 @@ void error_context(size_t num_iterations)
 	}
 }
 
+int run_checks_f(const int* values); // In check_bench.cpp
+int run_checks_s(const int* values); // In check_bench.cpp
+
+void checks_f(size_t num_iterations)
+{
+	std::vector<int> values(80, 7);
+	long long sum = 0;
+	for (size_t i = 0; i < num_iterations; ++i) {
+		sum += run_checks_f(values.data());
+	}
+	CHECK_GT_F(sum, 0);
+}
+
+void checks_s(size_t num_iterations)
+{
+	std::vector<int> values(80, 7);
+	long long sum = 0;
+	for (size_t i = 0; i < num_iterations; ++i) {
+		sum += run_checks_s(values.data());
+	}
+	CHECK_GT_F(sum, 0);
+}
+
 int main(int argc, char* argv[])
 {
 	const size_t kNumIterations = 50 * 1000;
@@ -105,6 +127,8 @@ int main(int argc, char* argv[])
 	loguru::add_file("loguru_bench.log", loguru::Truncate, loguru::Verbosity_INFO);
 
 	bench("ERROR_CONTEXT", error_context, kNumIterations * 100);
+	bench("1024 CHECK_*_F:", checks_f, kNumIterations);
+	bench("1024 CHECK_*_S:", checks_s, kNumIterations);
 
 	loguru::g_flush_interval_ms = 200;
 	bench("LOG_F string (buffered):", format_strings,   kNumIterations);
@@ -113,6 +137,17 @@ int main(int argc, char* argv[])
 	bench("LOG_S float  (buffered):", stream_float,     kNumIterations);
 	bench("RAW_LOG_F    (buffered):", raw_string_float, kNumIterations);
 
+	loguru::set_clock_mode(loguru::Clock_TSC);
+	bench("LOG_F string (buffered, TSC):", format_strings, kNumIterations);
+	loguru::set_clock_mode(loguru::Clock_Coarse);
+	bench("LOG_F string (buffered, coarse):", format_strings, kNumIterations);
+	loguru::set_clock_mode(loguru::Clock_System);
+
+	loguru::start_async();
+	bench("LOG_F string (async):", format_strings, kNumIterations);
+	bench("LOG_F float  (async):", format_float,   kNumIterations);
+	loguru::stop_async();
+
 	loguru::g_flush_interval_ms = 0;
 	bench("LOG_F string (unbuffered):", format_strings,   kNumIterations);
 	bench("LOG_F float  (unbuffered):", format_float,     kNumIterations);
@@ -2,7 +2,6 @@
 
 #include "loguru_example.hpp"
 
-#define LOGURU_IMPLEMENTATION 1
 #include "../loguru.hpp"
 
 int main(int argc, char* argv[])
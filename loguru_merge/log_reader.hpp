@@ -0,0 +1,122 @@
+// Reading loguru log files record by record. Shared by loguru_merge and loguru_parse.
+#pragma once
+
+#include <cstdio>
+#include <cstring>
+#include <string>
+
+#ifndef _WIN32
+	#include <fcntl.h>
+	#include <sys/mman.h>
+	#include <sys/stat.h>
+	#include <unistd.h>
+#endif
+
+#include "../loguru.hpp"
+
+// A whole file in memory: mapped where we can, else read.
+struct MappedFile
+{
+	const char* data = nullptr;
+	size_t      size = 0;
+#ifdef _WIN32
+	std::string contents;
+#endif
+
+	MappedFile() = default;
+	// Owns the mapping, so a copy would unmap it twice:
+	MappedFile(const MappedFile&) = delete;
+	MappedFile& operator=(const MappedFile&) = delete;
+
+	bool open(const char* path)
+	{
+#ifdef _WIN32
+		FILE* file = fopen(path, "rb");
+		if (!file) { return false; }
+		char buff[64 * 1024];
+		size_t num_read;
+		while ((num_read = fread(buff, 1, sizeof(buff), file)) > 0) {
+			contents.append(buff, num_read);
+		}
+		fclose(file);
+		data = contents.data();
+		size = contents.size();
+		return true;
+#else
+		const int fd = ::open(path, O_RDONLY);
+		if (fd == -1) { return false; }
+		struct stat st;
+		if (fstat(fd, &st) == -1) {
+			close(fd);
+			return false;
+		}
+		size = static_cast<size_t>(st.st_size);
+		if (size != 0) {
+			void* mapped = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+			if (mapped == MAP_FAILED) {
+				close(fd);
+				return false;
+			}
+			madvise(mapped, size, MADV_SEQUENTIAL);
+			data = static_cast<const char*>(mapped);
+		}
+		close(fd);
+		return true;
+#endif
+	}
+
+	~MappedFile()
+	{
+#ifndef _WIN32
+		if (data) { munmap(const_cast<char*>(data), size); }
+#endif
+	}
+};
+
+// Walks the records of one file. A record is a line with a preamble and the lines after it without one.
+class RecordReader
+{
+public:
+	RecordReader(const char* data, size_t size) : _ptr(data), _end(data + size) {}
+
+	// Moves to the next record. Returns false at the end of the file.
+	bool next()
+	{
+		if (record_end == _end) { return false; }
+		if (!record_end) {
+			if (!next_start(&record, &record_begin)) { return false; }
+		} else {
+			record_begin = record_end;
+			record = _next_record;
+		}
+		// The record goes on until the next line with a preamble:
+		const char* next_begin = nullptr;
+		record_end = next_start(&_next_record, &next_begin) ? next_begin : _end;
+		return true;
+	}
+
+	const char*     record_begin = nullptr;
+	const char*     record_end   = nullptr;
+	loguru::LogLine record;
+
+private:
+	// Finds the next line with a preamble. memchr is vectorized by the C library, so this is fast.
+	bool next_start(loguru::LogLine* out_line, const char** out_begin)
+	{
+		while (_ptr < _end) {
+			const char* line = _ptr;
+			const char* newline = static_cast<const char*>(memchr(_ptr, '\n', static_cast<size_t>(_end - _ptr)));
+			_ptr = newline ? newline + 1 : _end;
+			const char* line_end = newline ? newline : _end;
+			if (loguru::parse_log_line(line, static_cast<unsigned>(line_end - line), out_line)) {
+				*out_begin = line;
+				return true;
+			}
+		}
+		return false;
+	}
+
+	const char*     _ptr;
+	const char*     _end;
+	loguru::LogLine _next_record;
+};
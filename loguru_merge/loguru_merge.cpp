@@ -0,0 +1,95 @@
+// Merges log files written by loguru into one timeline, ordered by the preamble timestamps.
+//
+//     loguru_merge [-v VERBOSITY] [-t THREAD]... [-p PATTERN] FILE...
+//
+// -v keeps only records with a verbosity at or below VERBOSITY (a number, or INFO, WARNING, ERROR).
+// -t keeps only records from the given thread(s).
+// -p gives the preamble pattern the files were written with (see loguru::set_preamble_pattern).
+// Multi-line messages stay together. The header of each file (lines before the first record) is skipped.
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <functional>
+#include <queue>
+#include <string>
+#include <vector>
+
+#include "log_reader.hpp"
+
+int main(int argc, char* argv[])
+{
+	loguru::Verbosity max_verbosity = loguru::Verbosity_MAX;
+	std::vector<std::string> threads;
+	std::vector<const char*> paths;
+
+	for (int i = 1; i < argc; ++i) {
+		const std::string arg = argv[i];
+		if ((arg == "-v" || arg == "-t" || arg == "-p") && i + 1 < argc) {
+			const char* value = argv[++i];
+			if (arg == "-t") {
+				threads.push_back(value);
+			} else if (arg == "-p") {
+				if (!loguru::set_preamble_pattern(value)) { return 1; }
+			} else if (strcmp(value, "INFO") == 0) {
+				max_verbosity = loguru::Verbosity_INFO;
+			} else if (strcmp(value, "WARNING") == 0) {
+				max_verbosity = loguru::Verbosity_WARNING;
+			} else if (strcmp(value, "ERROR") == 0) {
+				max_verbosity = loguru::Verbosity_ERROR;
+			} else {
+				max_verbosity = static_cast<loguru::Verbosity>(atoi(value));
+			}
+		} else if (arg[0] == '-') {
+			fprintf(stderr, "Usage: %s [-v VERBOSITY] [-t THREAD]... [-p PATTERN] FILE...\n", argv[0]);
+			return 1;
+		} else {
+			paths.push_back(argv[i]);
+		}
+	}
+
+	std::vector<MappedFile> files(paths.size());
+	std::vector<RecordReader> readers;
+	for (size_t i = 0; i < paths.size(); ++i) {
+		if (!files[i].open(paths[i])) {
+			fprintf(stderr, "Failed to open '%s'\n", paths[i]);
+			return 1;
+		}
+		readers.push_back(RecordReader(files[i].data, files[i].size));
+	}
+
+	// Min-heap of (timestamp, file index), so equal timestamps keep the order of the files on the command line.
+	typedef std::pair<long long, size_t> HeapEntry;
+	std::priority_queue<HeapEntry, std::vector<HeapEntry>, std::greater<HeapEntry>> heap;
+	for (size_t i = 0; i < readers.size(); ++i) {
+		if (readers[i].next()) {
+			heap.push(HeapEntry{readers[i].record.timestamp_ns, i});
+		}
+	}
+
+	while (!heap.empty()) {
+		RecordReader& reader = readers[heap.top().second];
+		heap.pop();
+
+		const loguru::LogLine& record = reader.record;
+		bool keep = record.verbosity <= max_verbosity;
+		if (keep && !threads.empty()) {
+			keep = false;
+			for (const auto& thread : threads) {
+				keep |= (thread.size() == record.thread_length &&
+				         memcmp(thread.data(), record.thread, record.thread_length) == 0);
+			}
+		}
+		if (keep) {
+			fwrite(reader.record_begin, 1, static_cast<size_t>(reader.record_end - reader.record_begin), stdout);
+			if (reader.record_end[-1] != '\n') {
+				fputc('\n', stdout);
+			}
+		}
+
+		if (reader.next()) {
+			heap.push(HeapEntry{reader.record.timestamp_ns, static_cast<size_t>(&reader - readers.data())});
+		}
+	}
+	return 0;
+}
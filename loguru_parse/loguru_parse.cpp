@@ -0,0 +1,212 @@
+// Converts a loguru log file to columns, parsing it on all cores.
+//
+//     loguru_parse [-p PATTERN] [-j THREADS] LOG_FILE OUT_DIR
+//
+// -p gives the preamble pattern the file was written with (see loguru::set_preamble_pattern).
+// OUT_DIR gets one file per column, with a value per record in native byte order:
+//     time_ns.i64 uptime_ms.i64 line.u32 verbosity.i32
+//     thread.u32 file.u32    Indices into threads.txt and files.txt (one name per line).
+//     message.txt            All messages, each followed by a zero byte (multi-line messages keep their newlines).
+// The throughput of the parsing is printed to stderr.
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+#include "../loguru_merge/log_reader.hpp"
+
+// Names to indices, in order of first appearance.
+struct Dictionary
+{
+	std::unordered_map<std::string, unsigned> indices;
+	std::vector<std::string>                  names;
+	unsigned                                  last = 0;
+
+	unsigned add(const char* name, size_t length)
+	{
+		// Neighbouring records often share names, so try the last one first.
+		if (last < names.size() && names[last].size() == length && memcmp(names[last].data(), name, length) == 0) {
+			return last;
+		}
+		last = lookup(name, length);
+		return last;
+	}
+
+	unsigned lookup(const char* name, size_t length)
+	{
+		std::string key(name, length);
+		const auto it = indices.find(key);
+		if (it != indices.end()) { return it->second; }
+		const unsigned index = static_cast<unsigned>(names.size());
+		indices.emplace(key, index);
+		names.push_back(std::move(key));
+		return index;
+	}
+};
+
+struct Columns
+{
+	std::vector<long long> time_ns;
+	std::vector<long long> uptime_ms;
+	std::vector<unsigned>  line;
+	std::vector<int>       verbosity;
+	std::vector<unsigned>  thread;
+	std::vector<unsigned>  file;
+	std::string            message;
+	Dictionary             threads;
+	Dictionary             files;
+};
+
+// The first record starting at or after offset.
+static size_t record_start_after(const char* data, size_t size, size_t offset)
+{
+	while (offset < size) {
+		if (offset != 0 && data[offset - 1] != '\n') {
+			const void* newline = memchr(data + offset, '\n', size - offset);
+			if (!newline) { return size; }
+			offset = static_cast<size_t>(static_cast<const char*>(newline) - data) + 1;
+			continue;
+		}
+		const void* newline = memchr(data + offset, '\n', size - offset);
+		const size_t line_end = newline ? static_cast<size_t>(static_cast<const char*>(newline) - data) : size;
+		loguru::LogLine line;
+		if (loguru::parse_log_line(data + offset, static_cast<unsigned>(line_end - offset), &line)) {
+			return offset;
+		}
+		offset = line_end + 1;
+	}
+	return size;
+}
+
+static void parse_chunk(const char* data, size_t size, Columns* out)
+{
+	RecordReader reader(data, size);
+	while (reader.next()) {
+		const loguru::LogLine& record = reader.record;
+		out->time_ns.push_back(record.timestamp_ns);
+		out->uptime_ms.push_back(record.uptime_ms);
+		out->line.push_back(record.line);
+		out->verbosity.push_back(record.verbosity);
+		out->thread.push_back(out->threads.add(record.thread, record.thread_length));
+		out->file.push_back(out->files.add(record.file, record.file_length));
+		const char* message_end = reader.record_end;
+		if (message_end > record.message && message_end[-1] == '\n') { --message_end; }
+		out->message.append(record.message, message_end);
+		out->message.push_back('\0');
+	}
+}
+
+template<typename T>
+static bool write_column(const std::string& path, const std::vector<T>& values)
+{
+	FILE* file = fopen(path.c_str(), "wb");
+	if (!file) { return false; }
+	const bool ok = fwrite(values.data(), sizeof(T), values.size(), file) == values.size();
+	return fclose(file) == 0 && ok;
+}
+
+static bool write_text(const std::string& path, const std::string& text)
+{
+	FILE* file = fopen(path.c_str(), "wb");
+	if (!file) { return false; }
+	const bool ok = fwrite(text.data(), 1, text.size(), file) == text.size();
+	return fclose(file) == 0 && ok;
+}
+
+int main(int argc, char* argv[])
+{
+	unsigned num_threads = std::max(1u, std::thread::hardware_concurrency());
+	std::vector<const char*> paths;
+	for (int i = 1; i < argc; ++i) {
+		const std::string arg = argv[i];
+		if (arg == "-p" && i + 1 < argc) {
+			if (!loguru::set_preamble_pattern(argv[++i])) { return 1; }
+		} else if (arg == "-j" && i + 1 < argc) {
+			num_threads = std::max(1, atoi(argv[++i]));
+		} else if (arg[0] == '-') {
+			paths.clear();
+			break;
+		} else {
+			paths.push_back(argv[i]);
+		}
+	}
+	if (paths.size() != 2) {
+		fprintf(stderr, "Usage: %s [-p PATTERN] [-j THREADS] LOG_FILE OUT_DIR\n", argv[0]);
+		return 1;
+	}
+
+	MappedFile log_file;
+	if (!log_file.open(paths[0])) {
+		fprintf(stderr, "Failed to open '%s'\n", paths[0]);
+		return 1;
+	}
+
+	const auto start_time = std::chrono::steady_clock::now();
+
+	// Split into chunks of about the same size, each starting at a record:
+	std::vector<size_t> chunk_starts;
+	for (unsigned i = 0; i < num_threads; ++i) {
+		const size_t offset = log_file.size / num_threads * i;
+		const size_t start = record_start_after(log_file.data, log_file.size, offset);
+		if (chunk_starts.empty() || start > chunk_starts.back()) {
+			chunk_starts.push_back(start);
+		}
+	}
+	chunk_starts.push_back(log_file.size);
+
+	std::vector<Columns> chunks(chunk_starts.size() - 1);
+	std::vector<std::thread> workers;
+	for (size_t i = 0; i < chunks.size(); ++i) {
+		workers.emplace_back([&, i]() {
+			parse_chunk(log_file.data + chunk_starts[i], chunk_starts[i + 1] - chunk_starts[i], &chunks[i]);
+		});
+	}
+	for (auto& worker : workers) {
+		worker.join();
+	}
+
+	// Concatenate, renumbering the thread and file names of each chunk:
+	Columns all;
+	for (const auto& chunk : chunks) {
+		std::vector<unsigned> thread_ids, file_ids;
+		for (const auto& name : chunk.threads.names) { thread_ids.push_back(all.threads.add(name.data(), name.size())); }
+		for (const auto& name : chunk.files.names)   { file_ids.push_back(all.files.add(name.data(), name.size())); }
+		all.time_ns.insert(all.time_ns.end(), chunk.time_ns.begin(), chunk.time_ns.end());
+		all.uptime_ms.insert(all.uptime_ms.end(), chunk.uptime_ms.begin(), chunk.uptime_ms.end());
+		all.line.insert(all.line.end(), chunk.line.begin(), chunk.line.end());
+		all.verbosity.insert(all.verbosity.end(), chunk.verbosity.begin(), chunk.verbosity.end());
+		for (unsigned id : chunk.thread) { all.thread.push_back(thread_ids[id]); }
+		for (unsigned id : chunk.file)   { all.file.push_back(file_ids[id]); }
+		all.message += chunk.message;
+	}
+
+	const double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start_time).count();
+	fprintf(stderr, "Parsed %zu records (%.1f MB) on %zu threads in %.3f s: %.2f GB/s\n",
+		all.time_ns.size(), log_file.size / 1e6, chunks.size(), seconds, log_file.size / 1e9 / seconds);
+
+	std::string thread_names, file_names;
+	for (const auto& name : all.threads.names) { thread_names += name + "\n"; }
+	for (const auto& name : all.files.names)   { file_names += name + "\n"; }
+
+	const std::string dir = std::string(paths[1]) + "/";
+	if (!loguru::create_directories(dir.c_str()) ||
+	    !write_column(dir + "time_ns.i64",   all.time_ns) ||
+	    !write_column(dir + "uptime_ms.i64", all.uptime_ms) ||
+	    !write_column(dir + "line.u32",      all.line) ||
+	    !write_column(dir + "verbosity.i32", all.verbosity) ||
+	    !write_column(dir + "thread.u32",    all.thread) ||
+	    !write_column(dir + "file.u32",      all.file) ||
+	    !write_text(dir + "message.txt",     all.message) ||
+	    !write_text(dir + "threads.txt",     thread_names) ||
+	    !write_text(dir + "files.txt",       file_names)) {
+		fprintf(stderr, "Failed to write to '%s'\n", dir.c_str());
+		return 1;
+	}
+	return 0;
+}
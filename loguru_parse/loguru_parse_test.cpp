@@ -0,0 +1,168 @@
+// Checks that loguru_parse gives the same columns as parsing the log line by line with
+// loguru::parse_log_line, however the file is split into chunks.
+//
+//     loguru_parse_test PATH_TO_LOGURU_PARSE
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "../loguru_merge/log_reader.hpp"
+
+struct Expected
+{
+	std::vector<long long>   time_ns;
+	std::vector<unsigned>    line;
+	std::vector<int>         verbosity;
+	std::vector<std::string> thread;
+	std::vector<std::string> file;
+	std::string              message; // Zero-terminated, like message.txt.
+};
+
+static bool read_file(const std::string& path, std::string* out)
+{
+	FILE* file = fopen(path.c_str(), "rb");
+	if (!file) { return false; }
+	char buff[64 * 1024];
+	size_t num_read;
+	out->clear();
+	while ((num_read = fread(buff, 1, sizeof(buff), file)) > 0) {
+		out->append(buff, num_read);
+	}
+	fclose(file);
+	return true;
+}
+
+template<typename T>
+static std::vector<T> read_column(const std::string& path)
+{
+	std::string bytes;
+	CHECK_F(read_file(path, &bytes), "Missing '%s'", path.c_str());
+	std::vector<T> values(bytes.size() / sizeof(T));
+	memcpy(values.data(), bytes.data(), values.size() * sizeof(T));
+	return values;
+}
+
+static std::vector<std::string> read_names(const std::string& path)
+{
+	std::string text;
+	CHECK_F(read_file(path, &text), "Missing '%s'", path.c_str());
+	std::vector<std::string> names;
+	size_t begin = 0;
+	for (size_t end; (end = text.find('\n', begin)) != std::string::npos; begin = end + 1) {
+		names.push_back(text.substr(begin, end - begin));
+	}
+	return names;
+}
+
+static void write_log(const char* path)
+{
+	loguru::add_file(path, loguru::Truncate, loguru::Verbosity_MAX);
+	std::vector<std::thread> threads;
+	for (int t = 0; t < 4; ++t) {
+		threads.emplace_back([t]() {
+			loguru::set_thread_name(("writer " + std::to_string(t)).c_str());
+			for (int i = 0; i < 500; ++i) {
+				// Vary the length so the chunk boundaries land everywhere in a record:
+				const std::string padding(static_cast<size_t>((i * 7 + t * 13) % 97), 'x');
+				if (i % 10 == 0) {
+					LOG_F(WARNING, "multi-line %d %d\ncontinued %s\nand done", t, i, padding.c_str());
+				} else {
+					VLOG_F(i % 3, "record %d %d %s", t, i, padding.c_str());
+				}
+			}
+		});
+	}
+	for (auto& thread : threads) { thread.join(); }
+	loguru::remove_callback(path);
+}
+
+// The reference: each line either starts a record or continues the message of the previous one.
+static Expected parse_line_by_line(const char* path)
+{
+	MappedFile log_file;
+	CHECK_F(log_file.open(path));
+	Expected expected;
+	bool has_record = false;
+	for (size_t offset = 0; offset < log_file.size;) {
+		const void* newline = memchr(log_file.data + offset, '\n', log_file.size - offset);
+		const size_t end = newline ? static_cast<size_t>(static_cast<const char*>(newline) - log_file.data) : log_file.size;
+		const char* text = log_file.data + offset;
+		loguru::LogLine line;
+		if (loguru::parse_log_line(text, static_cast<unsigned>(end - offset), &line)) {
+			if (has_record) { expected.message.push_back('\0'); }
+			has_record = true;
+			expected.time_ns.push_back(line.timestamp_ns);
+			expected.line.push_back(line.line);
+			expected.verbosity.push_back(line.verbosity);
+			expected.thread.emplace_back(line.thread, line.thread_length);
+			expected.file.emplace_back(line.file, line.file_length);
+			expected.message.append(line.message, line.message_length);
+		} else if (has_record) {
+			expected.message.push_back('\n');
+			expected.message.append(text, end - offset);
+		}
+		offset = end + 1;
+	}
+	if (has_record) { expected.message.push_back('\0'); }
+	return expected;
+}
+
+static void check_columns(const Expected& expected, const std::string& dir, unsigned num_threads)
+{
+	const auto time_ns   = read_column<long long>(dir + "/time_ns.i64");
+	const auto line      = read_column<unsigned>(dir + "/line.u32");
+	const auto verbosity = read_column<int>(dir + "/verbosity.i32");
+	const auto thread    = read_column<unsigned>(dir + "/thread.u32");
+	const auto file      = read_column<unsigned>(dir + "/file.u32");
+	const auto threads   = read_names(dir + "/threads.txt");
+	const auto files     = read_names(dir + "/files.txt");
+	std::string message;
+	CHECK_F(read_file(dir + "/message.txt", &message));
+
+	const size_t num_records = expected.time_ns.size();
+	CHECK_EQ_F(time_ns.size(), num_records, "-j %u: records were split or duplicated", num_threads);
+	CHECK_EQ_F(line.size(), num_records);
+	CHECK_EQ_F(verbosity.size(), num_records);
+	CHECK_EQ_F(thread.size(), num_records);
+	CHECK_EQ_F(file.size(), num_records);
+	for (size_t i = 0; i < num_records; ++i) {
+		CHECK_EQ_F(time_ns[i], expected.time_ns[i], "-j %u, record %zu", num_threads, i);
+		CHECK_EQ_F(line[i], expected.line[i], "-j %u, record %zu", num_threads, i);
+		CHECK_EQ_F(verbosity[i], expected.verbosity[i], "-j %u, record %zu", num_threads, i);
+		CHECK_LT_F(thread[i], threads.size());
+		CHECK_F(threads[thread[i]] == expected.thread[i], "-j %u, record %zu", num_threads, i);
+		CHECK_LT_F(file[i], files.size());
+		CHECK_F(files[file[i]] == expected.file[i], "-j %u, record %zu", num_threads, i);
+	}
+	CHECK_F(message == expected.message, "-j %u: the messages differ", num_threads);
+}
+
+int main(int argc, char* argv[])
+{
+	loguru::init(argc, argv);
+	if (argc != 2) {
+		fprintf(stderr, "Usage: %s PATH_TO_LOGURU_PARSE\n", argv[0]);
+		return 1;
+	}
+	loguru::g_stderr_verbosity = loguru::Verbosity_ERROR;
+
+	const char* log_path = "loguru_parse_test.log";
+	write_log(log_path);
+	const Expected expected = parse_line_by_line(log_path);
+	CHECK_GT_F(expected.time_ns.size(), 4u * 500u); // Plus "Logging to ..."
+
+	// Many chunk counts, so chunks start in the middle of lines and multi-line messages:
+	for (unsigned num_threads : { 1u, 2u, 3u, 7u, 16u, 61u, 256u }) {
+		const std::string dir = "loguru_parse_test_" + std::to_string(num_threads);
+		const std::string command = std::string("\"") + argv[1] + "\" -j " + std::to_string(num_threads) +
+		                            " " + log_path + " " + dir;
+		CHECK_EQ_F(system(command.c_str()), 0, "Failed: %s", command.c_str());
+		check_columns(expected, dir, num_threads);
+	}
+	remove(log_path);
+	return 0;
+}
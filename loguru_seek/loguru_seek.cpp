@@ -0,0 +1,90 @@
+// Prints the part of a log file written in a time range, using the index written by
+// loguru::add_file(..., index_interval) to jump straight to it.
+//
+//     loguru_seek everything.log "2017-08-08 14:00:00" "2017-08-08 14:05:00"
+//
+// Times are local, like in the log preamble, or seconds since epoch.
+// Leave out the end time to print everything from the start time on.
+
+#include <cstdio>
+#include <cstdlib>
+#include <ctime>
+
+#include "../loguru.hpp"
+
+static bool parse_time(const char* str, long long* out_ns)
+{
+	tm time_info = tm();
+	double seconds = 0;
+	if (sscanf(str, "%d-%d-%d %d:%d:%lf", &time_info.tm_year, &time_info.tm_mon, &time_info.tm_mday,
+	           &time_info.tm_hour, &time_info.tm_min, &seconds) == 6) {
+		time_info.tm_year -= 1900;
+		time_info.tm_mon  -= 1;
+		time_info.tm_isdst = -1;
+		const time_t sec_since_epoch = mktime(&time_info);
+		if (sec_since_epoch == -1) {
+			return false;
+		}
+		*out_ns = (static_cast<long long>(sec_since_epoch) * 1000 * 1000 * 1000
+		           + static_cast<long long>(seconds * 1e9));
+		return true;
+	}
+	char* end = nullptr;
+	const double sec_since_epoch = strtod(str, &end);
+	if (end == str || *end != '\0') {
+		return false;
+	}
+	*out_ns = static_cast<long long>(sec_since_epoch * 1e9);
+	return true;
+}
+
+int main(int argc, char* argv[])
+{
+	if (argc != 3 && argc != 4) {
+		fprintf(stderr, "Usage: %s LOG_FILE BEGIN_TIME [END_TIME]\n", argv[0]);
+		fprintf(stderr, "Times are 'YYYY-MM-DD HH:MM:SS[.sss]' in local time, or seconds since epoch.\n");
+		return 1;
+	}
+
+	long long begin_ns = 0, end_ns = 0x7fffffffffffffffll;
+	if (!parse_time(argv[2], &begin_ns) || (argc == 4 && !parse_time(argv[3], &end_ns))) {
+		fprintf(stderr, "Failed to parse time\n");
+		return 1;
+	}
+
+	long long begin_offset = 0, end_offset = 0;
+	if (!loguru::find_in_log(argv[1], begin_ns, end_ns, &begin_offset, &end_offset)) {
+		fprintf(stderr, "Failed to read the index '%s.idx'\n", argv[1]);
+		return 1;
+	}
+
+	FILE* file = fopen(argv[1], "rb");
+	if (!file) {
+		fprintf(stderr, "Failed to open '%s'\n", argv[1]);
+		return 1;
+	}
+#ifdef _WIN32
+	_fseeki64(file, begin_offset, SEEK_SET);
+#else
+	fseeko(file, static_cast<off_t>(begin_offset), SEEK_SET);
+#endif
+
+	char buff[64 * 1024];
+	long long left = end_offset == -1 ? -1 : end_offset - begin_offset;
+	while (left != 0) {
+		size_t to_read = sizeof(buff);
+		if (left > 0 && static_cast<unsigned long long>(left) < to_read) {
+			to_read = static_cast<size_t>(left);
+		}
+		const size_t num_read = fread(buff, 1, to_read, file);
+		if (num_read == 0) {
+			break;
+		}
+		fwrite(buff, 1, num_read, stdout);
+		if (left > 0) {
+			left -= static_cast<long long>(num_read);
+		}
+	}
+	fclose(file);
+	return 0;
+}
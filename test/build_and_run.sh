@@ -48,6 +48,27 @@ test_failure "error_context"
 test_failure "throw_on_fatal"
 test_failure "throw_on_signal"
 test_success "callback"
+test_success "filters"
+test_success "verbosity_config"
+test_success "preamble_pattern"
+test_success "clock_modes"
+test_success "sampling"
+test_success "async"
+test_success "async_filters"
+test_success "async_memory"
+test_success "async_priority"
+test_success "async_fatal"
+test_success "batch_callback"
+test_success "log_context"
+test_success "thread_alias"
+test_success "scoped_verbosity"
+test_success "log_buffer_scope"
+test_success "text"
+test_success "index"
+test_success "parse_log_line"
+test_success "socket"
+test_success "fork"
+test_success "shared_file"
 echo "---------------------------------------------------------"
 echo "ALL TESTS PASSED!"
 echo "---------------------------------------------------------"
@@ -0,0 +1,42 @@
+// Built with LOGURU_USE_FILE_NAME, so the logging macros pass only the file name.
+#define LOGURU_USE_FILE_NAME    1
+#define LOGURU_IMPLEMENTATION   1
+#include "../loguru.hpp"
+
+#include <string>
+
+struct Collected
+{
+	std::string filename;
+	std::string preamble;
+};
+
+void collect(void* user_data, const loguru::Message& message)
+{
+	auto collected = reinterpret_cast<Collected*>(user_data);
+	collected->filename = message.filename;
+	collected->preamble = message.preamble;
+}
+
+int main(int argc, char* argv[])
+{
+	loguru::g_stderr_verbosity = loguru::Verbosity_WARNING;
+	loguru::init(argc, argv);
+
+	Collected collected;
+	loguru::add_callback("file_name_callback", collect, &collected, loguru::Verbosity_INFO);
+	LOG_F(INFO, "Where am I?");
+	CHECK_EQ_F(collected.filename, std::string("loguru_file_name_test.cpp"));
+	CHECK_F(collected.filename.find('/') == std::string::npos, "%s", collected.filename.c_str());
+	CHECK_F(collected.preamble.find("loguru_file_name_test.cpp:") != std::string::npos, "%s", collected.preamble.c_str());
+
+	// File filters only see the file name:
+	loguru::FilterRule rule;
+	rule.file = "loguru_file_name_test.cpp";
+	CHECK_F(loguru::add_filter("file_name_callback", rule));
+	collected = Collected();
+	LOG_F(INFO, "Still here");
+	CHECK_EQ_F(collected.filename, std::string("loguru_file_name_test.cpp"));
+	loguru::remove_callback("file_name_callback");
+	return 0;
+}
@@ -7,12 +7,24 @@
 #define LOGURU_IMPLEMENTATION   1
 #include "../loguru.hpp"
 
+#include <algorithm>
+#include <atomic>
+#include <map>
 #include <chrono>
+#include <memory>
 #include <string>
 #include <thread>
 
 #include <fstream>
 
+#ifdef __linux__
+	#include <sched.h> // sched_setaffinity
+#endif
+
+static_assert(loguru::file_name_offset("src/foo.cpp") == 4, "file_name_offset");
+static_assert(loguru::file_name_offset("C:\\src\\foo.cpp") == 7, "file_name_offset");
+static_assert(loguru::file_name_offset("foo.cpp") == 0, "file_name_offset");
+
 void the_one_where_the_problem_is(const std::vector<std::string>& v) {
 	ABORT_F("Abort deep in stack trace, msg: %s", v[0].c_str());
 }
@@ -306,6 +318,1305 @@ void test_log_callback()
 	CHECK_EQ_F(tester.num_close, 1u);
 }
 
+#ifndef _WIN32
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+// A stand-in for a local log agent: a datagram socket that we read from ourselves.
+struct SocketServer
+{
+	std::string path;
+	int         fd;
+
+	SocketServer()
+	{
+		path = "/tmp/loguru_test_" + std::to_string(getpid()) + ".sock";
+		unlink(path.c_str());
+		fd = socket(AF_UNIX, SOCK_DGRAM, 0);
+		CHECK_NE_F(fd, -1);
+		sockaddr_un addr;
+		memset(&addr, 0, sizeof(addr));
+		addr.sun_family = AF_UNIX;
+		strncpy(addr.sun_path, path.c_str(), sizeof(addr.sun_path) - 1);
+		CHECK_EQ_F(bind(fd, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)), 0);
+	}
+
+	~SocketServer()
+	{
+		close(fd);
+		unlink(path.c_str());
+	}
+
+	// Returns the concatenation of all datagrams waiting.
+	std::string receive_all()
+	{
+		std::string result;
+		char buff[4096];
+		for (;;) {
+			auto size = recv(fd, buff, sizeof(buff), MSG_DONTWAIT);
+			if (size <= 0) { break; }
+			result.append(buff, static_cast<size_t>(size));
+		}
+		return result;
+	}
+};
+
+// A log agent that takes a stream connection and reads whatever has arrived.
+struct StreamSocketServer
+{
+	std::string path;
+	int         fd;
+	int         connection = -1;
+
+	StreamSocketServer()
+	{
+		path = "/tmp/loguru_test_" + std::to_string(getpid()) + ".sock";
+		unlink(path.c_str());
+		fd = socket(AF_UNIX, SOCK_STREAM, 0);
+		CHECK_NE_F(fd, -1);
+		sockaddr_un addr;
+		memset(&addr, 0, sizeof(addr));
+		addr.sun_family = AF_UNIX;
+		strncpy(addr.sun_path, path.c_str(), sizeof(addr.sun_path) - 1);
+		CHECK_EQ_F(bind(fd, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)), 0);
+		CHECK_EQ_F(listen(fd, 4), 0);
+	}
+
+	~StreamSocketServer()
+	{
+		if (connection != -1) { close(connection); }
+		close(fd);
+		unlink(path.c_str());
+	}
+
+	std::string receive_all(size_t max_size = ~size_t(0))
+	{
+		if (connection == -1) {
+			connection = accept4(fd, nullptr, nullptr, SOCK_NONBLOCK);
+			if (connection == -1) { return ""; }
+		}
+		std::string result;
+		char buff[4096];
+		while (result.size() < max_size) {
+			auto size = recv(connection, buff, std::min(sizeof(buff), max_size - result.size()), MSG_DONTWAIT);
+			if (size <= 0) { break; }
+			result.append(buff, static_cast<size_t>(size));
+		}
+		return result;
+	}
+};
+
+void test_socket()
+{
+	loguru::g_flush_interval_ms = 1000 * 1000; // Only flush manually.
+	{
+		SocketServer server;
+		CHECK_F(loguru::add_socket(server.path.c_str(), loguru::Plain, loguru::Verbosity_INFO));
+		LOG_F(INFO, "plain socket message");
+		LOG_F(1, "SHOULD NOT BE SENT");
+		loguru::flush();
+		auto received = server.receive_all();
+		CHECK_F(received.find("plain socket message\n") != std::string::npos, "Got: '%s'", received.c_str());
+		CHECK_F(received.find("SHOULD NOT BE SENT") == std::string::npos);
+
+		// A stalled receiver must not block us:
+		for (int i = 0; i < 20000; ++i) {
+			LOG_F(INFO, "Stalled receiver %d", i);
+		}
+		std::string after_stall;
+		for (int i = 0; i < 1000 && after_stall.find("dropped") == std::string::npos; ++i) {
+			loguru::flush();
+			after_stall += server.receive_all();
+		}
+		CHECK_F(after_stall.find("dropped") != std::string::npos, "Expected a report of dropped records");
+		loguru::remove_callback(server.path.c_str());
+	}
+	{
+		SocketServer server;
+		CHECK_F(loguru::add_socket(server.path.c_str(), loguru::Journald, loguru::Verbosity_INFO));
+		LOG_F(WARNING, "journald\nmessage");
+		loguru::flush();
+		auto received = server.receive_all();
+		CHECK_F(received.find("PRIORITY=4\n") != std::string::npos, "Got: '%s'", received.c_str());
+		CHECK_F(received.find("journald\nmessage\n") != std::string::npos, "Got: '%s'", received.c_str());
+		CHECK_F(received.find("CODE_LINE=") != std::string::npos, "Got: '%s'", received.c_str());
+		loguru::remove_callback(server.path.c_str());
+	}
+	{
+		// A receiver that goes away is reconnected to, but not on every flush:
+		std::unique_ptr<SocketServer> server(new SocketServer());
+		const std::string path = server->path;
+		CHECK_F(loguru::add_socket(path.c_str(), loguru::Plain, loguru::Verbosity_INFO));
+		server.reset();
+		LOG_F(INFO, "while the receiver is away");
+		loguru::flush(); // Fails and starts the back-off.
+		server.reset(new SocketServer());
+		loguru::flush();
+		CHECK_F(server->receive_all().empty(), "Reconnected before the back-off ran out");
+		std::this_thread::sleep_for(std::chrono::milliseconds(LOGURU_SOCKET_RETRY_MS + 100));
+		loguru::flush();
+		auto received = server->receive_all();
+		CHECK_F(received.find("while the receiver is away\n") != std::string::npos, "Got: '%s'", received.c_str());
+		loguru::remove_callback(path.c_str());
+	}
+	{
+		// A record cut off by a lost stream connection is sent whole on the next one:
+		std::unique_ptr<StreamSocketServer> server(new StreamSocketServer());
+		const std::string path = server->path;
+		CHECK_F(loguru::add_socket(path.c_str(), loguru::Plain, loguru::Verbosity_INFO));
+		const std::string big(LOGURU_SOCKET_SPILL_SIZE / 2, 'z');
+		LOG_F(INFO, "big %s", big.c_str()); // More than the socket buffer takes at once.
+		CHECK_F(!server->receive_all(1000).empty());
+		server.reset(); // Leaves with most of the record unsent.
+		loguru::flush(); // Fails and starts the back-off.
+		server.reset(new StreamSocketServer());
+		std::this_thread::sleep_for(std::chrono::milliseconds(LOGURU_SOCKET_RETRY_MS + 100));
+		std::string received;
+		for (int i = 0; i < 1000 && received.find('\n') == std::string::npos; ++i) {
+			loguru::flush();
+			received += server->receive_all();
+		}
+		const auto begin = received.find("big ");
+		CHECK_NE_F(begin, std::string::npos, "Got: '%s'", received.substr(0, 100).c_str());
+		CHECK_EQ_F(received.substr(begin + 4), big + "\n");
+		CHECK_F(received.substr(0, begin).find('z') == std::string::npos, "Got the tail of the torn record first");
+		loguru::remove_callback(path.c_str());
+	}
+	loguru::g_flush_interval_ms = 0;
+}
+
+#include <sys/wait.h>
+
+void test_fork()
+{
+	loguru::g_flush_interval_ms = 50;
+	loguru::g_stderr_verbosity = loguru::Verbosity_WARNING;
+	// A unique temporary file, so a test run never leaves a log in the source tree:
+	const char* tmp_dir = getenv("TMPDIR");
+	std::string path_template = std::string(tmp_dir && *tmp_dir ? tmp_dir : "/tmp") + "/loguru_fork_test_XXXXXX";
+	const int fd = mkstemp(&path_template[0]);
+	CHECK_NE_F(fd, -1, "mkstemp failed: %s", strerror(errno));
+	close(fd);
+	const char* path = path_template.c_str();
+	loguru::add_file(path, loguru::Truncate, loguru::Verbosity_INFO);
+	LOG_F(INFO, "logged once before forking");
+
+	// Keep another thread busy logging so we fork while it holds s_mutex now and then:
+	std::atomic<bool> running { true };
+	std::thread spammer([&](){
+		loguru::set_thread_name("spammer");
+		while (running) { LOG_F(1, "spam"); LOG_F(INFO, "spam"); }
+	});
+
+	const int num_children = 20;
+	for (int i = 0; i < num_children; ++i) {
+		const pid_t pid = fork();
+		CHECK_NE_F(pid, -1);
+		if (pid == 0) {
+			alarm(10); // Don't hang the test if we deadlock.
+			LOG_F(INFO, "hello from child %d", i);
+			loguru::flush();
+			_exit(0);
+		}
+		int status = 0;
+		CHECK_EQ_F(waitpid(pid, &status, 0), pid);
+		CHECK_F(WIFEXITED(status) && WEXITSTATUS(status) == 0, "Child %d failed, status %d", i, status);
+	}
+
+	running = false;
+	spammer.join();
+
+	// Fork from within a callback, i.e. while holding the log lock, as system() in a callback would:
+	static pid_t s_callback_child = -1;
+	loguru::add_callback("fork_callback", [](void*, const loguru::Message& message){
+		if (strcmp(message.message, "fork here") == 0) {
+			s_callback_child = fork();
+		}
+	}, nullptr, loguru::Verbosity_INFO);
+	LOG_F(INFO, "fork here");
+	if (s_callback_child == 0) {
+		alarm(10);
+		std::thread([](){ LOG_F(INFO, "hello from a thread of the callback child"); }).join();
+		loguru::flush();
+		_exit(0);
+	}
+	CHECK_NE_F(s_callback_child, -1);
+	int status = 0;
+	CHECK_EQ_F(waitpid(s_callback_child, &status, 0), s_callback_child);
+	CHECK_F(WIFEXITED(status) && WEXITSTATUS(status) == 0, "Callback child failed, status %d", status);
+	loguru::remove_callback("fork_callback");
+	loguru::remove_callback(path);
+
+	std::ifstream file(path);
+	const std::string contents((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+	size_t num_before = 0;
+	for (size_t pos = 0; (pos = contents.find("logged once before forking", pos)) != std::string::npos; ++pos) {
+		num_before += 1;
+	}
+	CHECK_EQ_F(num_before, 1u, "Buffered output was duplicated by fork");
+	for (int i = 0; i < num_children; ++i) {
+		const std::string line = "hello from child " + std::to_string(i);
+		CHECK_F(contents.find(line) != std::string::npos, "Missing '%s'", line.c_str());
+	}
+	CHECK_F(contents.find("hello from a thread of the callback child") != std::string::npos);
+	unlink(path);
+	loguru::g_flush_interval_ms = 0;
+}
+
+void test_shared_file()
+{
+	loguru::g_stderr_verbosity = loguru::Verbosity_WARNING;
+	const char* path = "shared_file_test.log";
+	remove(path);
+	const std::string payload(100, 'x');
+	const std::string big(10000, 'y');
+
+	const int num_children = 4;
+	const int num_records = 500;
+	std::vector<pid_t> children;
+	for (int c = 0; c < num_children; ++c) {
+		const pid_t pid = fork();
+		CHECK_NE_F(pid, -1);
+		if (pid == 0) {
+			alarm(10);
+			loguru::g_flush_interval_ms = (c % 2 == 0) ? 0 : 100; // Both one write per record, and batches.
+			loguru::add_file(path, loguru::AppendShared, loguru::Verbosity_INFO);
+			for (int r = 0; r < num_records; ++r) {
+				LOG_F(INFO, "child %d record %d %s", c, r, payload.c_str());
+				if (r == num_records / 2) {
+					LOG_F(INFO, "big %s", big.c_str());
+				}
+			}
+			loguru::remove_callback(path);
+			_exit(0);
+		}
+		children.push_back(pid);
+	}
+	for (pid_t pid : children) {
+		int status = 0;
+		CHECK_EQ_F(waitpid(pid, &status, 0), pid);
+		CHECK_F(WIFEXITED(status) && WEXITSTATUS(status) == 0, "Child failed, status %d", status);
+	}
+
+	std::ifstream file(path);
+	std::map<std::string, std::string> pieces; // Split records, glued back together.
+	int num_lines = 0;
+	for (std::string line; std::getline(file, line); ) {
+		if (line.size() > 0 && line[0] == '[') {
+			const auto id_end = line.find(' ');
+			const auto frame_end = line.find("] ");
+			CHECK_F(id_end != std::string::npos && frame_end != std::string::npos, "%s", line.c_str());
+			const auto length = std::stoul(line.substr(line.rfind(' ', frame_end - 1) + 1));
+			CHECK_EQ_F(line.size() - frame_end - 2, length);
+			pieces[line.substr(1, id_end - 1)] += line.substr(frame_end + 2);
+		} else if (line.find("| child ") != std::string::npos) {
+			CHECK_F(line.size() > payload.size() && line.compare(line.size() - payload.size(), payload.size(), payload) == 0,
+			        "Broken line: '%s'", line.c_str());
+			num_lines += 1;
+		}
+	}
+	CHECK_EQ_F(num_lines, num_children * num_records);
+	CHECK_EQ_F(pieces.size(), static_cast<size_t>(num_children));
+	const std::string big_end = "| big " + big;
+	for (const auto& record : pieces) {
+		CHECK_F(record.second.size() > big_end.size() &&
+		        record.second.compare(record.second.size() - big_end.size(), big_end.size(), big_end) == 0,
+		        "Bad split record %s", record.first.c_str());
+	}
+}
+#endif // _WIN32
+
+void test_filters()
+{
+	CallbackTester by_file, by_thread, by_message;
+	loguru::add_callback("by_file",    callbackPrint, &by_file,    loguru::Verbosity_INFO);
+	loguru::add_callback("by_thread",  callbackPrint, &by_thread,  loguru::Verbosity_INFO);
+	loguru::add_callback("by_message", callbackPrint, &by_message, loguru::Verbosity_INFO);
+
+	loguru::FilterRule file_rule;
+	file_rule.file = "test/*_test.cpp";
+	CHECK_F(loguru::add_filter("by_file", file_rule));
+	loguru::FilterRule other_file_rule;
+	other_file_rule.file = "no_such_file.cpp";
+	CHECK_F(loguru::add_filter("by_file", other_file_rule));
+
+	loguru::FilterRule thread_rule;
+	thread_rule.thread = "noisy*";
+	CHECK_F(loguru::add_filter("by_thread", thread_rule));
+
+	loguru::FilterRule message_rule;
+	message_rule.message = "request [0-9]+";
+	CHECK_F(loguru::add_filter("by_message", message_rule));
+
+	loguru::FilterRule bad_rule;
+	bad_rule.message = "(";
+	CHECK_F(!loguru::add_filter("by_message", bad_rule));
+
+	for (int i = 0; i < 3; ++i) {
+		LOG_F(INFO, "Handling request %d", i); // Same call site: routing is cached.
+	}
+	LOG_F(INFO, "Something else");
+	std::thread([]{
+		loguru::set_thread_name("noisy thread");
+		LOG_F(INFO, "Noise");
+	}).join();
+
+	CHECK_EQ_F(by_file.num_print,    5u);
+	CHECK_EQ_F(by_thread.num_print,  1u);
+	CHECK_EQ_F(by_message.num_print, 3u);
+
+	CHECK_F(loguru::clear_filters("by_thread"));
+	LOG_F(INFO, "Everyone gets this");
+	CHECK_EQ_F(by_thread.num_print,  2u);
+	CHECK_EQ_F(by_message.num_print, 3u);
+
+	loguru::remove_callback("by_file");
+	loguru::remove_callback("by_thread");
+	loguru::remove_callback("by_message");
+}
+
+void test_verbosity_config()
+{
+	CallbackTester tester;
+	loguru::add_callback("config_callback", callbackPrint, &tester, loguru::Verbosity_INFO);
+
+	const char* path = "loguru_test_verbosity.cfg";
+	FILE* file = fopen(path, "w");
+	CHECK_NOTNULL_F(file);
+	fprintf(file, "# Test config\n");
+	fprintf(file, "stderr                 = WARNING\n");
+	fprintf(file, "sink config_callback   = 2\n");
+	fprintf(file, "module no_such_file.cpp = 9\n");
+	fclose(file);
+
+	CHECK_F(loguru::load_verbosity_config(path));
+	CHECK_EQ_F(loguru::g_stderr_verbosity, loguru::Verbosity_WARNING);
+	CHECK_EQ_F(loguru::current_verbosity_cutoff(), 9);
+	const auto num_print_before = tester.num_print;
+	LOG_F(2, "Should reach the callback");
+	CHECK_EQ_F(tester.num_print, num_print_before + 1);
+
+	// A broken config is not applied at all:
+	file = fopen(path, "w");
+	fprintf(file, "stderr = 3\n");
+	fprintf(file, "sink no_such_sink = 9\n");
+	fclose(file);
+	CHECK_F(!loguru::load_verbosity_config(path));
+	CHECK_EQ_F(loguru::g_stderr_verbosity, loguru::Verbosity_WARNING);
+
+	// A watched config is applied until the watcher is stopped:
+	file = fopen(path, "w");
+	fprintf(file, "stderr = 3\n");
+	fclose(file);
+	loguru::watch_verbosity_config(path, 0); // Must not spin.
+	for (int i = 0; i < 200 && loguru::stderr_verbosity() != 3; ++i) {
+		std::this_thread::sleep_for(std::chrono::milliseconds(10));
+	}
+	CHECK_EQ_F(loguru::g_stderr_verbosity, 3);
+	loguru::unwatch_verbosity_config();
+	file = fopen(path, "w");
+	fprintf(file, "stderr = WARNING\n");
+	fclose(file);
+	std::this_thread::sleep_for(std::chrono::milliseconds(100));
+	CHECK_EQ_F(loguru::g_stderr_verbosity, 3);
+	loguru::g_stderr_verbosity = loguru::Verbosity_WARNING;
+
+#ifndef _WIN32
+	// SIGHUP is left to the program unless asked for:
+	struct sigaction before, during, after;
+	sigaction(SIGHUP, nullptr, &before);
+	loguru::watch_verbosity_config(path);
+	sigaction(SIGHUP, nullptr, &during);
+	CHECK_F(during.sa_handler == before.sa_handler);
+	loguru::unwatch_verbosity_config();
+	loguru::watch_verbosity_config(path, 1000, true);
+	sigaction(SIGHUP, nullptr, &during);
+	CHECK_F(during.sa_handler != before.sa_handler);
+	loguru::unwatch_verbosity_config();
+	sigaction(SIGHUP, nullptr, &after);
+	CHECK_F(after.sa_handler == before.sa_handler);
+	loguru::g_stderr_verbosity = loguru::Verbosity_WARNING;
+#endif // _WIN32
+
+	// Per-module stderr verbosity:
+	loguru::clear_module_verbosities();
+	loguru::g_stderr_verbosity = loguru::Verbosity_OFF;
+	loguru::set_module_verbosity("*_test.cpp", 1);
+	LOG_F(1, "Should be on stderr, thanks to the module verbosity");
+	loguru::clear_module_verbosities();
+	LOG_F(INFO, "SHOULD NOT BE ON STDERR");
+	loguru::g_stderr_verbosity = loguru::Verbosity_INFO;
+
+	CHECK_F(loguru::set_callback_verbosity("config_callback", loguru::Verbosity_WARNING));
+	const auto num_print = tester.num_print;
+	LOG_F(INFO, "Should not reach the callback");
+	CHECK_EQ_F(tester.num_print, num_print);
+
+	loguru::remove_callback("config_callback");
+	remove(path);
+}
+
+void callbackStorePreamble(void* user_data, const loguru::Message& message)
+{
+	*reinterpret_cast<std::string*>(user_data) = message.preamble;
+}
+
+void test_preamble_pattern()
+{
+	std::string preamble;
+	loguru::add_callback("preamble_callback", callbackStorePreamble, &preamble, loguru::Verbosity_INFO);
+
+	CHECK_F(!loguru::set_preamble_pattern("%Q"));
+	CHECK_F(loguru::set_preamble_pattern("[%t] %f:%l %v| 100%%: "));
+	LOG_F(WARNING, "Custom preamble");
+	const auto expected = loguru::textprintf("[%-16s] %16s:%-5d WARN| 100%%: ", "main thread", "loguru_test.cpp", __LINE__ - 1);
+	CHECK_EQ_F(preamble, expected.c_str());
+
+	CHECK_F(loguru::set_preamble_pattern("%D %T.%ms (%ups) [%t]%f:%l %v| "));
+	LOG_F(INFO, "Default preamble again");
+	CHECK_EQ_F(preamble.size(), std::string("2017-08-08 16:15:03.123 (   0.000s) [main thread     ] loguru_test.cpp:123      0| ").size());
+	loguru::remove_callback("preamble_callback");
+}
+
+void callbackStoreTimestamp(void* user_data, const loguru::Message& message)
+{
+	*reinterpret_cast<long long*>(user_data) = message.timestamp_ns;
+}
+
+void test_clock_modes()
+{
+	long long timestamp_ns = 0;
+	loguru::add_callback("timestamp_callback", callbackStoreTimestamp, &timestamp_ns, loguru::Verbosity_INFO);
+
+	for (auto mode : { loguru::Clock_System, loguru::Clock_Coarse, loguru::Clock_TSC }) {
+		const auto used_mode = loguru::set_clock_mode(mode);
+		{
+			LOG_SCOPE_F(INFO, "Clock mode %d (asked for %d)", used_mode, mode);
+			const auto system_ns = std::chrono::duration_cast<std::chrono::nanoseconds>(
+				std::chrono::system_clock::now().time_since_epoch()).count();
+			LOG_F(INFO, "Timestamped");
+			const auto diff_ms = (timestamp_ns - system_ns) / 1000000;
+			CHECK_F(-50 < diff_ms && diff_ms < 50, "Clock mode %d is off by %lld ms", used_mode, diff_ms);
+			CHECK_LE_F(timestamp_ns, loguru::timestamp_ns());
+		}
+	}
+
+	loguru::set_clock_mode(loguru::Clock_System);
+	loguru::remove_callback("timestamp_callback");
+}
+
+struct SampleCounter
+{
+	int      num_messages = 0;
+	unsigned last_sample_rate = 0;
+	std::string last_prefix;
+};
+
+void callbackCountSamples(void* user_data, const loguru::Message& message)
+{
+	auto counter = reinterpret_cast<SampleCounter*>(user_data);
+	counter->num_messages += 1;
+	counter->last_sample_rate = message.sample_rate;
+	counter->last_prefix = message.prefix;
+}
+
+int count_evaluations(int* num_evaluations)
+{
+	return ++*num_evaluations;
+}
+
+void test_sampling()
+{
+	loguru::g_stderr_verbosity = loguru::Verbosity_WARNING;
+	SampleCounter counter;
+	loguru::add_callback("sample_callback", callbackCountSamples, &counter, loguru::Verbosity_MAX);
+
+	loguru::set_sample_rate(loguru::Verbosity_5, 10);
+	for (int i = 0; i < 10000; ++i) {
+		LOG_F(5, "Sampled %d", i);
+	}
+	CHECK_EQ_F(counter.last_sample_rate, 10u);
+	CHECK_EQ_F(counter.last_prefix, std::string("[1/10] "));
+	LOG_F(INFO, "Per-verbosity sampling kept %d of 10000", counter.num_messages);
+	CHECK_F(700 < counter.num_messages && counter.num_messages < 1300, "Kept %d", counter.num_messages);
+
+	counter = SampleCounter();
+	LOG_F(6, "Not sampled");
+	CHECK_EQ_F(counter.num_messages, 1);
+	CHECK_EQ_F(counter.last_sample_rate, 1u);
+	CHECK_EQ_F(counter.last_prefix, std::string(""));
+	loguru::set_sample_rate(loguru::Verbosity_5, 1);
+
+	counter = SampleCounter();
+	int num_evaluations = 0;
+	for (int i = 0; i < 10000; ++i) {
+		LOG_SAMPLED_F(INFO, 100, "Sampled call site %d", count_evaluations(&num_evaluations));
+	}
+	LOG_F(INFO, "Per-call-site sampling kept %d of 10000", num_evaluations);
+	CHECK_EQ_F(counter.num_messages - 1, num_evaluations, "Arguments should only be evaluated when sampled");
+	CHECK_F(50 < num_evaluations && num_evaluations < 150, "Kept %d", num_evaluations);
+
+	counter = SampleCounter();
+	LOG_SAMPLED_F(INFO, 1, "Always");
+	CHECK_EQ_F(counter.num_messages, 1);
+	CHECK_EQ_F(counter.last_sample_rate, 1u);
+	loguru::remove_callback("sample_callback");
+}
+
+struct AsyncCollector
+{
+	std::vector<std::string>     messages;
+	std::vector<std::string>     preambles;
+	std::vector<std::string>     indentations;
+	std::vector<std::thread::id> writers;
+	int                          num_flushes = 0;
+};
+
+void callbackCollect(void* user_data, const loguru::Message& message)
+{
+	auto collector = reinterpret_cast<AsyncCollector*>(user_data);
+	collector->messages.push_back(message.message);
+	collector->preambles.push_back(message.preamble);
+	collector->indentations.push_back(message.indentation);
+	collector->writers.push_back(std::this_thread::get_id());
+}
+
+void test_async()
+{
+	loguru::g_stderr_verbosity = loguru::Verbosity_WARNING;
+	AsyncCollector collector;
+	loguru::add_callback("async_callback", callbackCollect, &collector, loguru::Verbosity_INFO);
+	loguru::start_async(64 * 1024, 5); // Small shards, so producers sometimes fill them up.
+	collector = AsyncCollector();
+
+	const int num_threads = 8;
+	const int num_messages = 5000;
+	std::vector<std::thread> threads;
+	for (int t = 0; t < num_threads; ++t) {
+		threads.emplace_back([t](){
+			loguru::set_thread_name(("producer " + std::to_string(t)).c_str());
+			for (int i = 0; i < num_messages; ++i) {
+	#ifdef __linux__
+				if (i % 100 == 0) {
+					// Hop between CPUs, and so between shards, while the drains go on:
+					const unsigned num_cpus = std::max(1u, std::thread::hardware_concurrency());
+					cpu_set_t cpus;
+					CPU_ZERO(&cpus);
+					CPU_SET((t + i / 100) % num_cpus, &cpus);
+					sched_setaffinity(0, sizeof(cpus), &cpus);
+				}
+	#endif
+				LOG_F(INFO, "%d %d", t, i);
+			}
+		});
+	}
+	for (auto& thread : threads) { thread.join(); }
+	loguru::flush();
+
+	CHECK_EQ_F(collector.messages.size(), size_t(num_threads * num_messages));
+	std::vector<int> next(num_threads, 0);
+	for (size_t i = 0; i < collector.messages.size(); ++i) {
+		int t, n;
+		CHECK_EQ_F(sscanf(collector.messages[i].c_str(), "%d %d", &t, &n), 2);
+		CHECK_EQ_F(n, next[t], "Messages from thread %d out of order", t);
+		next[t] += 1;
+		// The preamble is rendered by the logging thread:
+		const std::string thread_name = "producer " + std::to_string(t);
+		CHECK_F(collector.preambles[i].find(thread_name) != std::string::npos, "%s", collector.preambles[i].c_str());
+	}
+
+#ifdef __linux__
+	{
+		// One thread alternating between two CPUs puts its records on two shards, often with the same coarse
+		// timestamp. They must still come out in the order they were logged:
+		cpu_set_t allowed;
+		CPU_ZERO(&allowed);
+		sched_getaffinity(0, sizeof(allowed), &allowed);
+		std::vector<int> cpus;
+		for (int cpu = 0; cpu < CPU_SETSIZE && cpus.size() < 2; ++cpu) {
+			if (CPU_ISSET(cpu, &allowed)) { cpus.push_back(cpu); }
+		}
+		if (cpus.size() == 2 && loguru::set_clock_mode(loguru::Clock_Coarse) == loguru::Clock_Coarse) {
+			loguru::start_async(1024 * 1024, 60 * 1000); // Only drain when asked to.
+			collector = AsyncCollector();
+			const int num_hops = 1000;
+			for (int i = 0; i < num_hops; ++i) {
+				cpu_set_t cpu;
+				CPU_ZERO(&cpu);
+				CPU_SET(cpus[i % 2], &cpu);
+				sched_setaffinity(0, sizeof(cpu), &cpu);
+				LOG_F(INFO, "hop %d", i);
+			}
+			sched_setaffinity(0, sizeof(allowed), &allowed);
+			loguru::flush();
+			CHECK_EQ_F(collector.messages.size(), size_t(num_hops));
+			for (int i = 0; i < num_hops; ++i) {
+				CHECK_EQ_F(collector.messages[i], "hop " + std::to_string(i), "Hops out of order");
+			}
+			loguru::start_async(64 * 1024, 5);
+		}
+		loguru::set_clock_mode(loguru::Clock_System);
+	}
+#endif
+
+	// Without a flush, the background thread writes it:
+	collector = AsyncCollector();
+	LOG_F(INFO, "written in the background");
+	for (int i = 0; i < 100 && collector.messages.empty(); ++i) {
+		std::this_thread::sleep_for(std::chrono::milliseconds(10));
+	}
+	loguru::flush();
+	CHECK_EQ_F(collector.messages.size(), 1u);
+	CHECK_NE_F(collector.writers[0] == std::this_thread::get_id(), true);
+
+	// The file name is copied, so it may be gone by the time the record is written:
+	loguru::start_async(64 * 1024, 60 * 1000); // Only drain when asked to.
+	static std::string s_filename;
+	loguru::add_callback("filename_callback", [](void*, const loguru::Message& message){
+		s_filename = message.filename;
+	}, nullptr, loguru::Verbosity_INFO);
+	{
+		std::string file = "src/temporary.cpp";
+		loguru::log(loguru::Verbosity_INFO, file.c_str(), 1, "from a temporary file name");
+		file.assign(file.size(), 'x');
+	}
+	loguru::flush();
+	CHECK_EQ_F(s_filename, std::string("src/temporary.cpp"));
+	loguru::remove_callback("filename_callback");
+
+	// Scopes are buffered too, and written in order with their indentation:
+	loguru::start_async(64 * 1024, 60 * 1000); // Only drain when asked to.
+	collector = AsyncCollector();
+	LOG_F(INFO, "before scope");
+	{
+		LOG_SCOPE_F(INFO, "scope");
+		LOG_F(INFO, "in scope");
+	}
+	LOG_F(INFO, "after scope");
+	CHECK_F(collector.messages.empty(), "A scope should not drain the async buffers");
+	loguru::stop_async();
+	CHECK_EQ_F(collector.messages.size(), 5u);
+	CHECK_EQ_F(collector.messages[0], std::string("before scope"));
+	CHECK_EQ_F(collector.messages[1], std::string("scope"));
+	CHECK_EQ_F(collector.messages[2], std::string("in scope"));
+	CHECK_EQ_F(collector.messages[3].substr(0, 2), std::string("} "));
+	CHECK_EQ_F(collector.messages[4], std::string("after scope"));
+	CHECK_EQ_F(collector.indentations[1], std::string());
+	CHECK_EQ_F(collector.indentations[2], std::string(".   "));
+	CHECK_EQ_F(collector.indentations[3], std::string());
+	CHECK_EQ_F(collector.indentations[4], std::string());
+
+	collector = AsyncCollector();
+	LOG_F(INFO, "synchronous again");
+	CHECK_EQ_F(collector.messages.size(), 1u);
+	CHECK_F(collector.writers[0] == std::this_thread::get_id());
+	loguru::remove_callback("async_callback");
+}
+
+void test_async_filters()
+{
+	loguru::g_stderr_verbosity = loguru::Verbosity_WARNING;
+	AsyncCollector collector;
+	loguru::add_callback("async_callback", callbackCollect, &collector, loguru::Verbosity_INFO);
+	loguru::FilterRule rule;
+	rule.thread = "keep*";
+	CHECK_F(loguru::add_filter("async_callback", rule));
+	loguru::start_async(64 * 1024, 60 * 1000); // Drained by stop_async, on this thread.
+	collector = AsyncCollector();
+
+	std::thread([](){
+		loguru::set_thread_name("keep me");
+		LOG_F(INFO, "kept");
+	}).join();
+	std::thread([](){
+		loguru::set_thread_name("drop me");
+		LOG_F(INFO, "dropped");
+		LOG_THREAD_ALIAS("keep#7");
+		LOG_F(INFO, "kept by alias");
+	}).join();
+	LOG_F(INFO, "dropped from main");
+	loguru::stop_async();
+
+	CHECK_EQ_F(collector.messages.size(), 2u);
+	CHECK_EQ_F(collector.messages[0], std::string("kept"));
+	CHECK_EQ_F(collector.messages[1], std::string("kept by alias"));
+	loguru::remove_callback("async_callback");
+}
+
+void test_async_memory()
+{
+	loguru::g_stderr_verbosity = loguru::Verbosity_WARNING;
+	AsyncCollector collector;
+	loguru::add_callback("async_callback", callbackCollect, &collector, loguru::Verbosity_INFO);
+	// Huge pages or mlock may not be available here; start_async should warn and go on without them.
+	loguru::start_async(100 * 1000, 5,
+		loguru::AsyncMemory_Populate | loguru::AsyncMemory_HugePages | loguru::AsyncMemory_Lock);
+	// Any such warnings reach the callback too, so look for the summary among them:
+	const auto summary = std::find_if(collector.messages.begin(), collector.messages.end(), [](const std::string& message) {
+		return message.find("Async logging:") == 0;
+	});
+	CHECK_F(summary != collector.messages.end(), "No summary among %u messages", (unsigned)collector.messages.size());
+	CHECK_F(summary->find("populated") != std::string::npos, "%s", summary->c_str());
+
+	collector = AsyncCollector();
+	for (int i = 0; i < 10000; ++i) {
+		LOG_F(INFO, "%d", i);
+	}
+	loguru::stop_async();
+	CHECK_EQ_F(collector.messages.size(), 10000u);
+	loguru::remove_callback("async_callback");
+}
+
+void flushCollect(void* user_data)
+{
+	reinterpret_cast<AsyncCollector*>(user_data)->num_flushes += 1;
+}
+
+void test_async_priority()
+{
+	loguru::g_stderr_verbosity = loguru::Verbosity_WARNING;
+	loguru::g_flush_interval_ms = 60 * 1000; // Only our explicit flushes.
+	AsyncCollector collector;
+	loguru::add_callback("async_callback", callbackCollect, &collector, loguru::Verbosity_INFO, nullptr, flushCollect);
+	loguru::start_async(64 * 1024, 60 * 1000); // Only drain when asked to.
+	loguru::set_async_priority_verbosity(loguru::Verbosity_WARNING);
+	collector = AsyncCollector();
+
+	LOG_F(INFO, "first");
+	LOG_F(INFO, "second");
+	CHECK_F(collector.messages.empty());
+	LOG_F(WARNING, "warning");
+	CHECK_EQ_F(collector.messages.size(), 3u, "The warning should have written out what was pending");
+	CHECK_EQ_F(collector.messages[0], std::string("first"));
+	CHECK_EQ_F(collector.messages[2], std::string("warning"));
+	CHECK_GE_F(collector.num_flushes, 1);
+
+	LOG_F(INFO, "third");
+	CHECK_EQ_F(collector.messages.size(), 3u);
+	loguru::stop_async();
+	CHECK_EQ_F(collector.messages.size(), 4u);
+	loguru::set_async_priority_verbosity(loguru::Verbosity_FATAL);
+	loguru::remove_callback("async_callback");
+	loguru::g_flush_interval_ms = 0;
+}
+
+void test_async_fatal()
+{
+	loguru::g_stderr_verbosity = loguru::Verbosity_OFF;
+	AsyncCollector collector;
+	loguru::add_callback("async_callback", callbackCollect, &collector, loguru::Verbosity_INFO);
+	loguru::start_async(1024 * 1024, 60 * 1000); // Only drain when asked to.
+	loguru::set_fatal_handler([](const loguru::Message& message){
+		throw std::runtime_error(message.message);
+	});
+	collector = AsyncCollector();
+
+	std::vector<std::thread> threads;
+	for (int t = 0; t < 4; ++t) {
+		threads.emplace_back([t](){
+			for (int i = 0; i < 100; ++i) {
+				LOG_F(INFO, "%d %d", t, i);
+			}
+		});
+	}
+	for (auto& thread : threads) { thread.join(); }
+	CHECK_F(collector.messages.empty());
+
+	try {
+		CHECK_F(false, "pending records first");
+	} catch (std::runtime_error&) {
+	}
+	CHECK_GE_F(collector.messages.size(), 4u * 100u + 1u);
+	CHECK_EQ_F(collector.messages.back(), std::string("pending records first"));
+	for (size_t i = 0; i < 4u * 100u; ++i) {
+		int t, n;
+		CHECK_EQ_F(sscanf(collector.messages[i].c_str(), "%d %d", &t, &n), 2,
+				   "Every pending record should precede the FATAL, got '%s'", collector.messages[i].c_str());
+	}
+
+	// The fatal handler threw, so we live on, and so does async logging:
+	LOG_F(INFO, "async again");
+	CHECK_NE_F(collector.messages.back(), std::string("async again"));
+	loguru::flush();
+	CHECK_EQ_F(collector.messages.back(), std::string("async again"));
+	loguru::stop_async();
+	loguru::set_fatal_handler(nullptr);
+	loguru::remove_callback("async_callback");
+}
+
+struct BatchCollector
+{
+	std::vector<std::string> messages;
+	std::vector<unsigned>    batch_sizes;
+	int                      num_flushes = 0;
+	std::atomic<unsigned>    num_batches { 0 }; // For polling from another thread.
+};
+
+void callbackBatch(void* user_data, const loguru::Message* messages, unsigned num_messages)
+{
+	auto collector = reinterpret_cast<BatchCollector*>(user_data);
+	for (unsigned i = 0; i < num_messages; ++i) {
+		collector->messages.push_back(messages[i].message);
+	}
+	collector->batch_sizes.push_back(num_messages);
+	collector->num_batches += 1;
+}
+
+void flushBatch(void* user_data)
+{
+	reinterpret_cast<BatchCollector*>(user_data)->num_flushes += 1;
+}
+
+void test_batch_callback()
+{
+	loguru::g_stderr_verbosity = loguru::Verbosity_WARNING;
+	BatchCollector collector;
+	loguru::add_batch_callback("batch", callbackBatch, &collector, loguru::Verbosity_INFO, 10, 60 * 1000,
+							   nullptr, flushBatch);
+	for (int i = 0; i < 25; ++i) {
+		LOG_F(INFO, "%d", i);
+	}
+	CHECK_F(collector.batch_sizes == (std::vector<unsigned>{10, 10}));
+	loguru::flush();
+	CHECK_F(collector.batch_sizes == (std::vector<unsigned>{10, 10, 5}));
+	CHECK_EQ_F(collector.num_flushes, 3);
+	CHECK_EQ_F(collector.messages.size(), 25u);
+	for (int i = 0; i < 25; ++i) {
+		CHECK_EQ_F(collector.messages[i], std::to_string(i));
+	}
+
+	// With async logging, the drain fills the batches:
+	collector.batch_sizes.clear();
+	loguru::start_async(1024 * 1024, 60 * 1000);
+	for (int i = 0; i < 20; ++i) {
+		LOG_F(INFO, "%d", i);
+	}
+	CHECK_EQ_F(collector.messages.size(), 25u);
+	loguru::stop_async();
+	CHECK_F(collector.batch_sizes == (std::vector<unsigned>{10, 10}));
+	loguru::remove_callback("batch");
+
+	// A partial batch is handed over by the background flusher once it is old enough:
+	BatchCollector slow;
+	loguru::add_batch_callback("slow_batch", callbackBatch, &slow, loguru::Verbosity_INFO, 1000, 20);
+	LOG_F(INFO, "lonely");
+	for (int i = 0; i < 200 && slow.num_batches == 0; ++i) {
+		std::this_thread::sleep_for(std::chrono::milliseconds(10));
+	}
+	CHECK_EQ_F(slow.num_batches.load(), 1u);
+	CHECK_EQ_F(slow.messages[0], std::string("lonely"));
+
+	// What is pending when the callback is removed is handed over first:
+	LOG_F(INFO, "last");
+	loguru::remove_callback("slow_batch");
+	CHECK_EQ_F(slow.messages.back(), std::string("last"));
+
+	// A priority message flushes the sinks, but leaves batches that are not due alone:
+	BatchCollector partial;
+	loguru::add_batch_callback("partial_batch", callbackBatch, &partial, loguru::Verbosity_INFO, 1000, 60 * 1000);
+	loguru::g_flush_interval_ms = 60 * 1000;
+	loguru::start_async(1024 * 1024, 60 * 1000);
+	loguru::set_async_priority_verbosity(loguru::Verbosity_WARNING);
+	LOG_F(INFO, "pending");
+	LOG_F(WARNING, "priority");
+	CHECK_EQ_F(partial.num_batches.load(), 0u, "The warning should not hand over a partial batch");
+	loguru::stop_async();
+	loguru::set_async_priority_verbosity(loguru::Verbosity_FATAL);
+	loguru::g_flush_interval_ms = 0;
+	loguru::remove_callback("partial_batch");
+	CHECK_GE_F(partial.messages.size(), 2u);
+	CHECK_EQ_F(partial.messages[partial.messages.size() - 2], std::string("pending"));
+	CHECK_EQ_F(partial.messages.back(), std::string("priority"));
+}
+
+void callbackContext(void* user_data, const loguru::Message& message)
+{
+	reinterpret_cast<std::vector<std::string>*>(user_data)->push_back(std::string(message.context) + message.message);
+}
+
+void test_log_context()
+{
+	loguru::g_stderr_verbosity = loguru::Verbosity_WARNING;
+	std::vector<std::string> lines;
+	loguru::add_callback("context_callback", callbackContext, &lines, loguru::Verbosity_INFO);
+
+	LOG_F(INFO, "none");
+	{
+		LOG_CONTEXT("req", 42);
+		LOG_F(INFO, "one");
+		{
+			LOG_CONTEXT("tenant", "acme");
+			LOG_F(INFO, "two");
+			CHECK_EQ_F(std::string(loguru::get_log_context()), std::string("req=42 tenant=\"acme\""));
+			std::thread([](){ LOG_F(INFO, "other thread"); }).join();
+		}
+		loguru::start_async(64 * 1024, 60 * 1000);
+		lines.pop_back(); // "Async logging: ..."
+		LOG_F(INFO, "async");
+		loguru::stop_async();
+	}
+	LOG_F(INFO, "none again");
+	CHECK_EQ_F(std::string(loguru::get_log_context()), std::string());
+
+	const std::vector<std::string> expected = {
+		"none",
+		"[req=42] one",
+		"[req=42 tenant=\"acme\"] two",
+		"other thread",
+		"[req=42] async",
+		"none again",
+	};
+	CHECK_EQ_F(lines.size(), expected.size());
+	for (size_t i = 0; i < expected.size(); ++i) {
+		CHECK_EQ_F(lines[i], expected[i]);
+	}
+	loguru::remove_callback("context_callback");
+}
+
+void test_thread_alias()
+{
+	loguru::g_stderr_verbosity = loguru::Verbosity_WARNING;
+	AsyncCollector collector;
+	loguru::add_callback("alias_callback", callbackCollect, &collector, loguru::Verbosity_INFO);
+	{
+		LOG_THREAD_ALIAS("ingest#1234");
+		LOG_F(INFO, "task");
+		{
+			LOG_THREAD_ALIAS("a very long task name indeed");
+			LOG_F(INFO, "nested");
+		}
+		LOG_F(INFO, "task again");
+	}
+	LOG_F(INFO, "no task");
+
+	CHECK_EQ_F(collector.preambles.size(), 4u);
+	CHECK_F(collector.preambles[0].find("[ingest#1234") != std::string::npos, "%s", collector.preambles[0].c_str());
+	CHECK_F(collector.preambles[1].find("[a very long task]") != std::string::npos, "%s", collector.preambles[1].c_str());
+	CHECK_F(collector.preambles[2].find("[ingest#1234") != std::string::npos, "%s", collector.preambles[2].c_str());
+	CHECK_F(collector.preambles[3].find("[main thread") != std::string::npos, "%s", collector.preambles[3].c_str());
+
+	// Thread filters see the alias too:
+	collector = AsyncCollector();
+	loguru::FilterRule ingest;
+	ingest.thread = "ingest#*";
+	CHECK_F(loguru::add_filter("alias_callback", ingest));
+	LOG_F(INFO, "filtered out");
+	{
+		LOG_THREAD_ALIAS("ingest#7");
+		LOG_F(INFO, "let through");
+	}
+	CHECK_EQ_F(collector.messages.size(), 1u);
+	CHECK_EQ_F(collector.messages[0], std::string("let through"));
+	loguru::remove_callback("alias_callback");
+}
+
+void test_scoped_verbosity()
+{
+	loguru::g_stderr_verbosity = loguru::Verbosity_OFF;
+	AsyncCollector collector;
+	loguru::add_callback("verbosity_callback", callbackCollect, &collector, loguru::Verbosity_INFO);
+	CHECK_EQ_F(loguru::current_verbosity_cutoff(), loguru::Verbosity_INFO);
+	{
+		loguru::ScopedVerbosity debug(5);
+		CHECK_EQ_F(loguru::current_verbosity_cutoff(), loguru::Verbosity_INFO, "Nobody takes raised messages");
+	}
+	CHECK_F(loguru::set_callback_raised_verbosity("verbosity_callback", 9));
+	AsyncCollector shallow;
+	loguru::add_callback("shallow_callback", callbackCollect, &shallow, loguru::Verbosity_INFO);
+	CHECK_F(loguru::set_callback_raised_verbosity("shallow_callback", 3));
+	CHECK_EQ_F(loguru::current_verbosity_cutoff(), loguru::Verbosity_INFO);
+	{
+		loguru::ScopedVerbosity debug(5);
+		CHECK_F(loguru::current_verbosity_cutoff() >= 5);
+		CHECK_F(loguru::current_verbosity_cutoff() < 6);
+		{
+			loguru::ScopedVerbosity lower(2); // Does not lower the outer one.
+			CHECK_EQ_F(loguru::thread_verbosity(), 5);
+		}
+		CHECK_EQ_F(loguru::thread_verbosity(), 5);
+
+		// Other threads are not affected, unless told to be:
+		const auto verbosity = loguru::thread_verbosity();
+		std::thread([=](){
+			CHECK_F(loguru::current_verbosity_cutoff() < 5);
+			VLOG_F(5, "not raised");
+			loguru::ScopedVerbosity inherited(verbosity);
+			CHECK_F(loguru::current_verbosity_cutoff() >= 5);
+			VLOG_F(5, "inherited");
+		}).join();
+
+		// Each callback takes raised messages up to its own limit:
+		VLOG_F(5, "raised");
+		LOG_F(INFO, "within");
+		const std::vector<std::string> expected = { "inherited", "raised", "within" };
+		CHECK_EQ_F(collector.messages.size(), expected.size());
+		for (size_t i = 0; i < expected.size(); ++i) {
+			CHECK_EQ_F(collector.messages[i], expected[i]);
+		}
+		CHECK_EQ_F(shallow.messages.size(), 1u);
+		CHECK_EQ_F(shallow.messages[0], std::string("within"));
+	}
+	loguru::remove_callback("shallow_callback");
+	CHECK_EQ_F(loguru::thread_verbosity(), loguru::Verbosity_OFF);
+	CHECK_F(loguru::current_verbosity_cutoff() < 5);
+
+	// Raised messages keep their order among the async ones of the thread:
+	loguru::start_async(64 * 1024, 60 * 1000);
+	collector = AsyncCollector();
+	LOG_F(INFO, "before");
+	{
+		loguru::ScopedVerbosity debug(9);
+		LOG_F(INFO, "raised");
+		VLOG_F(5, "raised verbose");
+		LOG_F(INFO, "raised again");
+	}
+	VLOG_F(5, "no longer raised");
+	LOG_F(INFO, "between");
+	{
+		LOG_BUFFER_SCOPE(9);
+		LOG_F(INFO, "in scope");
+		VLOG_F(5, "held back, then dropped");
+		LOG_F(INFO, "in scope again");
+	}
+	LOG_F(INFO, "after");
+	loguru::stop_async();
+	const std::vector<std::string> expected = { "before", "raised", "raised verbose", "raised again", "between",
+												"in scope", "in scope again", "after" };
+	CHECK_EQ_F(collector.messages.size(), expected.size());
+	for (size_t i = 0; i < expected.size(); ++i) {
+		CHECK_EQ_F(collector.messages[i], expected[i]);
+	}
+
+	// The cutoff is cached per thread, but changes from any thread, or to g_stderr_verbosity directly, are seen:
+	CHECK_EQ_F(loguru::current_verbosity_cutoff(), loguru::Verbosity_INFO);
+	std::thread([](){ CHECK_F(loguru::set_callback_verbosity("verbosity_callback", 7)); }).join();
+	CHECK_EQ_F(loguru::current_verbosity_cutoff(), 7);
+	loguru::g_stderr_verbosity = 8;
+	CHECK_EQ_F(loguru::current_verbosity_cutoff(), 8);
+	loguru::g_stderr_verbosity = loguru::Verbosity_OFF;
+	std::thread([](){ loguru::set_module_verbosity("*.cpp", 9); }).join();
+	CHECK_EQ_F(loguru::current_verbosity_cutoff(), 9);
+	loguru::clear_module_verbosities();
+	CHECK_EQ_F(loguru::current_verbosity_cutoff(), 7);
+	loguru::remove_callback("verbosity_callback");
+}
+
+void test_log_buffer_scope()
+{
+	loguru::g_stderr_verbosity = loguru::Verbosity_OFF;
+	AsyncCollector collector;
+	loguru::add_callback("buffer_callback", callbackCollect, &collector, loguru::Verbosity_MAX);
+
+	{
+		LOG_BUFFER_SCOPE(9);
+		VLOG_F(5, "debug");
+		LOG_F(INFO, "success");
+	}
+	CHECK_EQ_F(collector.messages.size(), 1u);
+	CHECK_EQ_F(collector.messages[0], std::string("success"));
+
+	collector = AsyncCollector();
+	{
+		LOG_BUFFER_SCOPE(9);
+		VLOG_F(5, "first");
+		LOG_F(INFO, "info");
+		{
+			LOG_BUFFER_SCOPE(9); // Joins the outer one.
+			VLOG_F(3, "second");
+		}
+		CHECK_EQ_F(collector.messages.size(), 1u);
+		LOG_F(WARNING, "failure");
+		VLOG_F(5, "after");
+	}
+	const std::vector<std::string> expected = { "info", "first", "second", "failure", "after" };
+	CHECK_EQ_F(collector.messages.size(), expected.size());
+	for (size_t i = 0; i < expected.size(); ++i) {
+		CHECK_EQ_F(collector.messages[i], expected[i]);
+	}
+	const size_t time_size = std::string("2000-01-01 00:00:00.000").size();
+	CHECK_LE_F(collector.preambles[1].substr(0, time_size), collector.preambles[0].substr(0, time_size),
+			   "Held back messages keep their time");
+
+	// A failed CHECK writes them out too:
+	collector = AsyncCollector();
+	loguru::set_fatal_handler([](const loguru::Message& message){
+		throw std::runtime_error(message.message);
+	});
+	try {
+		LOG_BUFFER_SCOPE(9);
+		VLOG_F(5, "context");
+		CHECK_F(false, "broken");
+	} catch (std::runtime_error&) {
+	}
+	loguru::set_fatal_handler(nullptr);
+	CHECK_GE_F(collector.messages.size(), 2u);
+	CHECK_EQ_F(collector.messages[0], std::string("context"));
+	CHECK_EQ_F(collector.messages.back(), std::string("broken"));
+
+	// Held back messages keep their indentation, and the threshold is up to the scope:
+	loguru::g_stderr_verbosity = loguru::Verbosity_INFO; // For the indentation.
+	collector = AsyncCollector();
+	{
+		LOG_BUFFER_SCOPE(9, 1);
+		{
+			LOG_SCOPE_F(INFO, "work");
+			LOG_SCOPE_F(1, "detail"); // Indents the callback, but not stderr.
+			VLOG_F(1, "direct");
+			VLOG_F(2, "indented");
+		}
+		CHECK_EQ_F(std::count(collector.messages.begin(), collector.messages.end(), "direct"), 1);
+		CHECK_EQ_F(std::count(collector.messages.begin(), collector.messages.end(), "indented"), 0);
+		LOG_F(WARNING, "failure");
+	}
+	const auto direct = std::find(collector.messages.begin(), collector.messages.end(), "direct") - collector.messages.begin();
+	const auto indented = std::find(collector.messages.begin(), collector.messages.end(), "indented") - collector.messages.begin();
+	CHECK_LT_F(static_cast<size_t>(indented), collector.messages.size());
+	CHECK_EQ_F(collector.indentations[direct], std::string(".   .   "));
+	CHECK_EQ_F(collector.indentations[indented], collector.indentations[direct]);
+	CHECK_EQ_F(collector.indentations.back(), std::string(), "The failure is outside the LOG_SCOPE_F");
+	loguru::g_stderr_verbosity = loguru::Verbosity_OFF;
+	loguru::remove_callback("buffer_callback");
+}
+
+const char* log_while_formatting(AsyncCollector* collector)
+{
+	LOG_F(INFO, "inner %s", std::string(100, 'i').c_str());
+	CHECK_EQ_F(collector->messages.back(), "inner " + std::string(100, 'i'));
+	return "outer";
+}
+
+void test_text()
+{
+	auto number = loguru::textprintf("%d", 42);
+	CHECK_EQ_F(std::string(number.c_str()), std::string("42"));
+	auto moved = std::move(number);
+	CHECK_EQ_F(std::string(moved.c_str()), std::string("42"));
+
+	const std::string long_string(1000, 'x');
+	auto long_text = loguru::textprintf("%s", long_string.c_str());
+	auto long_moved = std::move(long_text);
+	CHECK_EQ_F(std::string(long_moved.c_str()), long_string);
+
+	for (const char* str : { "short", long_string.c_str() }) {
+		auto copy = loguru::Text::copy(str);
+		CHECK_EQ_F(std::string(copy.c_str()), std::string(str));
+		char* released = copy.release();
+		CHECK_EQ_F(std::string(released), std::string(str));
+		free(released);
+	}
+	CHECK_F(loguru::textprintf().empty());
+
+	loguru::g_stderr_verbosity = loguru::Verbosity_WARNING;
+	AsyncCollector collector;
+	loguru::add_callback("text_callback", callbackCollect, &collector, loguru::Verbosity_INFO);
+	LOG_F(INFO, "%s", long_string.c_str()); // Longer than the scratch buffer.
+	CHECK_EQ_F(collector.messages.back(), long_string);
+	LOG_F(INFO, "%s %s", log_while_formatting(&collector), std::string(100, 'o').c_str());
+	CHECK_EQ_F(collector.messages.back(), "outer " + std::string(100, 'o'));
+	loguru::remove_callback("text_callback");
+
+	ERROR_CONTEXT("short value", 7);
+	const auto context = loguru::get_error_context();
+	CHECK_F(strstr(context.c_str(), "short value") != nullptr, "%s", context.c_str());
+}
+
+void callbackTimestamp(void* user_data, const loguru::Message& message)
+{
+	reinterpret_cast<std::vector<long long>*>(user_data)->push_back(message.timestamp_ns);
+}
+
+void test_index()
+{
+	loguru::g_stderr_verbosity = loguru::Verbosity_WARNING;
+	const char* path = "index_test.log";
+	CHECK_F(loguru::add_file(path, loguru::Truncate, loguru::Verbosity_INFO, 256));
+	std::vector<long long> timestamps;
+	loguru::add_callback("timestamps", callbackTimestamp, &timestamps, loguru::Verbosity_INFO);
+	for (int i = 0; i < 1000; ++i) {
+		LOG_F(INFO, "line %d", i);
+	}
+	loguru::remove_callback("timestamps");
+	loguru::remove_callback(path);
+	CHECK_EQ_F(timestamps.size(), 1000u);
+
+	long long begin = 0, end = 0;
+	CHECK_F(loguru::find_in_log(path, timestamps[500], timestamps[600], &begin, &end));
+	CHECK_F(0 < begin && begin < end, "[%lld, %lld)", begin, end);
+
+	std::ifstream file(path);
+	const std::string contents((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+	const std::string range = contents.substr(static_cast<size_t>(begin), static_cast<size_t>(end - begin));
+	CHECK_F(range.find("line 500\n") != std::string::npos, "%s", range.c_str());
+	CHECK_F(range.find("line 600\n") != std::string::npos, "%s", range.c_str());
+	CHECK_F(range.find("line 490\n") == std::string::npos, "%s", range.c_str());
+	CHECK_F(range.find("line 610\n") == std::string::npos, "%s", range.c_str());
+
+	CHECK_F(loguru::find_in_log(path, timestamps[990], timestamps[999] + 1, &begin, &end));
+	CHECK_EQ_F(end, -1ll);
+	CHECK_F(loguru::find_in_log(path, 0, timestamps[0], &begin, &end));
+	CHECK_EQ_F(begin, 0ll);
+	CHECK_F(!loguru::find_in_log("no_such_file.log", 0, 0, &begin, &end));
+}
+
+struct LineCollector
+{
+	std::vector<std::string> lines;
+	std::vector<std::string> messages;
+	std::vector<unsigned>    line_numbers;
+	std::vector<long long>   timestamps;
+};
+
+void callbackLine(void* user_data, const loguru::Message& message)
+{
+	auto collector = reinterpret_cast<LineCollector*>(user_data);
+	collector->lines.push_back(std::string(message.preamble) + message.indentation + message.prefix + message.message);
+	collector->messages.push_back(message.message);
+	collector->line_numbers.push_back(message.line);
+	collector->timestamps.push_back(message.timestamp_ns);
+}
+
+void test_parse_log_line()
+{
+	loguru::g_stderr_verbosity = loguru::Verbosity_WARNING;
+	LineCollector collector;
+	loguru::add_callback("lines", callbackLine, &collector, loguru::Verbosity_MAX);
+	loguru::set_thread_name("parser thread");
+	LOG_F(WARNING, "first\nsecond");
+	VLOG_F(3, "verbose");
+	CHECK_F(loguru::set_preamble_pattern("%ns %v [%t] %f:%l| "));
+	LOG_F(ERROR, "with ns");
+	CHECK_F(loguru::set_preamble_pattern("%D %T.%ms (%ups) [%t]%f:%l %v| "));
+	loguru::remove_callback("lines");
+	CHECK_EQ_F(collector.lines.size(), 3u);
+
+	const loguru::Verbosity expected_verbosity[] = { loguru::Verbosity_WARNING, 3, loguru::Verbosity_ERROR };
+	for (size_t i = 0; i < collector.lines.size(); ++i) {
+		const std::string& text = collector.lines[i];
+		if (i == 2) {
+			CHECK_F(loguru::set_preamble_pattern("%ns %v [%t] %f:%l| "));
+		}
+		const std::string first_line = text.substr(0, text.find('\n'));
+		loguru::LogLine line;
+		CHECK_F(loguru::parse_log_line(first_line.c_str(), static_cast<unsigned>(first_line.size()), &line), "%s", text.c_str());
+		CHECK_EQ_F(line.verbosity, expected_verbosity[i]);
+		CHECK_EQ_F(std::string(line.thread, line.thread_length), std::string("parser thread"));
+		CHECK_EQ_F(std::string(line.file, line.file_length), std::string("loguru_test.cpp"));
+		CHECK_EQ_F(line.line, collector.line_numbers[i]);
+		CHECK_EQ_F(std::string(line.message, line.message_length), collector.messages[i].substr(0, line.message_length));
+		if (i == 2) {
+			CHECK_EQ_F(line.timestamp_ns, collector.timestamps[i]);
+		} else {
+			CHECK_EQ_F(line.timestamp_ns / 1000000, collector.timestamps[i] / 1000000);
+		}
+	}
+	CHECK_F(loguru::set_preamble_pattern("%D %T.%ms (%ups) [%t]%f:%l %v| "));
+
+	loguru::LogLine line;
+	CHECK_F(!loguru::parse_log_line("second", 6, &line));
+	CHECK_F(!loguru::parse_log_line("", 0, &line));
+}
+
 #if defined _WIN32 && defined _DEBUG
 #define USE_WIN_DBG_HOOK
 static int winDbgHook(int reportType, char *message, int *)
@@ -415,6 +1726,50 @@ int main(int argc, char* argv[])
 			throw_on_signal();
 		} else if (test == "callback") {
 			test_log_callback();
+		} else if (test == "filters") {
+			test_filters();
+		} else if (test == "verbosity_config") {
+			test_verbosity_config();
+		} else if (test == "preamble_pattern") {
+			test_preamble_pattern();
+		} else if (test == "clock_modes") {
+			test_clock_modes();
+		} else if (test == "sampling") {
+			test_sampling();
+		} else if (test == "async") {
+			test_async();
+		} else if (test == "async_filters") {
+			test_async_filters();
+		} else if (test == "async_memory") {
+			test_async_memory();
+		} else if (test == "async_priority") {
+			test_async_priority();
+		} else if (test == "async_fatal") {
+			test_async_fatal();
+		} else if (test == "batch_callback") {
+			test_batch_callback();
+		} else if (test == "log_context") {
+			test_log_context();
+		} else if (test == "thread_alias") {
+			test_thread_alias();
+		} else if (test == "scoped_verbosity") {
+			test_scoped_verbosity();
+		} else if (test == "log_buffer_scope") {
+			test_log_buffer_scope();
+		} else if (test == "text") {
+			test_text();
+		} else if (test == "index") {
+			test_index();
+		} else if (test == "parse_log_line") {
+			test_parse_log_line();
+#ifndef _WIN32
+		} else if (test == "socket") {
+			test_socket();
+		} else if (test == "fork") {
+			test_fork();
+		} else if (test == "shared_file") {
+			test_shared_file();
+#endif
 		} else if (test == "hang") {
 			loguru::add_file("hang.log", loguru::Truncate, loguru::Verbosity_INFO);
 			test_hang_2();